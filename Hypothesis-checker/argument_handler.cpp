@@ -1,4 +1,5 @@
 #include "argument_handler.hpp"
+#include "scheduler.hpp"
 
 namespace cube {
 	void argument_handler::parse_args(int argc, char ** argv) {
@@ -60,10 +61,95 @@ namespace cube {
 				arg_id++;
 				break;
 
+			case 't': //Number of threads
+				if (arg_id == argc || argv[arg_id][0] == '-') {
+					errors::argument_error("Number of threads expected after -t!");
+				}
+				try {
+					threads = std::stoul(argv[arg_id]);
+				}
+				catch (...) {
+					errors::argument_error("Invalid number of threads: " + (std::string)argv[arg_id]);
+				}
+				if (threads == 0) {
+					errors::argument_error("At least one thread is required!");
+				}
+				arg_id++;
+				break;
+
+			case 's': //Engine of the path search
+				if (arg_id == argc || argv[arg_id][0] == '-') {
+					errors::argument_error("Solver name expected after -s!");
+				}
+				if ((std::string)argv[arg_id] == "search")
+					solver = solver_type::SEARCH;
+				else if ((std::string)argv[arg_id] == "bitboard")
+					solver = solver_type::BITBOARD;
+				else
+					errors::argument_error("Unknown solver: " + (std::string)argv[arg_id]);
+				arg_id++;
+				break;
+
+			case 'g': //Generation of the table of subcubes
+				if (arg_id == argc || argv[arg_id][0] == '-') {
+					errors::argument_error("Output file name expected after -g!");
+				}
+				is_table_output = true;
+				table_output_file = argv[arg_id];
+				arg_id++;
+				break;
+
+			case 'u': //Table of subcubes used by the search
+				if (arg_id == argc || argv[arg_id][0] == '-') {
+					errors::argument_error("Input file name expected after -u!");
+				}
+				is_table_input = true;
+				table_input_file = argv[arg_id];
+				arg_id++;
+				break;
+
+			case 'l': //Calibration log of the cost model
+				if (arg_id == argc || argv[arg_id][0] == '-') {
+					errors::argument_error("Output file name expected after -l!");
+				}
+				is_cost_log = true;
+				cost_log_file = argv[arg_id];
+				arg_id++;
+				break;
+
+			case 'r': //Binary path file rendered into text
+				if (arg_id == argc || argv[arg_id][0] == '-') {
+					errors::argument_error("Input file name expected after -r!");
+				}
+				is_path_render = true;
+				path_input_file = argv[arg_id];
+				arg_id++;
+				break;
+
+			case 'w': //Rendered path output file
+				if (arg_id == argc || argv[arg_id][0] == '-') {
+					errors::argument_error("Output file name expected after -w!");
+				}
+				render_output_file = argv[arg_id];
+				arg_id++;
+				break;
+
+			case 'f': //Trusted input matchings
+				is_trusted = true;
+				break;
+
+			case 'b': //Benchmark of concurrent containers
+				is_benchmark = true;
+				break;
+
 			default:
 				errors::argument_error("Unknown argument skipped:" + (std::string)argv[arg_id], 0);
 			}
 		}
+
+		//The rendering requires both files
+		if (is_path_render != !render_output_file.empty())
+			errors::argument_error("Both -r and -w are required for rendering of paths!");
 	}
 
 	bool argument_handler::is_input = false;
@@ -71,9 +157,22 @@ namespace cube {
 	bool argument_handler::is_output = false;
 	bool argument_handler::is_comp_output = false;
 	bool argument_handler::is_path_output = false;
+	bool argument_handler::is_benchmark = false;
+	bool argument_handler::is_table_output = false;
+	bool argument_handler::is_table_input = false;
+	bool argument_handler::is_cost_log = false;
+	bool argument_handler::is_trusted = false;
+	bool argument_handler::is_path_render = false;
 	std::string argument_handler::input_file;
 	std::string argument_handler::comp_input_file;
 	std::string argument_handler::output_file;
 	std::string argument_handler::comp_output_file;
 	std::string argument_handler::path_output_file;
+	std::string argument_handler::table_output_file;
+	std::string argument_handler::table_input_file;
+	std::string argument_handler::cost_log_file;
+	std::string argument_handler::path_input_file;
+	std::string argument_handler::render_output_file;
+	size_t argument_handler::threads = default_thread_count();
+	solver_type argument_handler::solver = solver_type::SEARCH;
 }
\ No newline at end of file
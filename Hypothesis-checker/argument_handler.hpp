@@ -1,6 +1,7 @@
 #ifndef ARGUMENT_HANDLER_
 #define ARGUMENT_HANDLER_
 
+#include "settings.hpp"
 #include "errors.hpp"
 #include <string>
 
@@ -26,6 +27,24 @@ namespace cube {
 		//Whether output file for paths was selected
 		static bool is_path_output;
 
+		//Whether the benchmark should be run instead of the checker
+		static bool is_benchmark;
+
+		//Whether the table of subcubes should be generated instead of the checker
+		static bool is_table_output;
+
+		//Whether the table of subcubes (of dimension one lower) was selected
+		static bool is_table_input;
+
+		//Whether the calibration log of the cost model should be written
+		static bool is_cost_log;
+
+		//Whether the input matchings are trusted to be unique (written by this program), thus they are copied into a flat array instead of inserted into a hash set
+		static bool is_trusted;
+
+		//Whether the binary file of paths should be rendered into text instead of the checker
+		static bool is_path_render;
+
 		//Input file name 
 		static std::string input_file;
 
@@ -40,6 +59,27 @@ namespace cube {
 
 		//Path output file name
 		static std::string path_output_file;
+
+		//Table of subcubes output file name
+		static std::string table_output_file;
+
+		//Table of subcubes input file name
+		static std::string table_input_file;
+
+		//Calibration log file name
+		static std::string cost_log_file;
+
+		//Binary path input file name (rendered into text)
+		static std::string path_input_file;
+
+		//Rendered path output file name
+		static std::string render_output_file;
+
+		//Number of worker threads
+		static size_t threads;
+
+		//Engine of the search for Hamiltonian paths
+		static solver_type solver;
 	};
 }
 
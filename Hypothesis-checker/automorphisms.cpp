@@ -0,0 +1,57 @@
+#include "automorphisms.hpp"
+
+namespace cube {
+	bool automorphisms::build() {
+		forward_tables.resize(AUTOMORPHISMS_CNT);
+		inverse_tables.resize(AUTOMORPHISMS_CNT);
+		low_permutations_tables.resize(VERTICES);
+
+		//Go through permutations in lexicographical order, permutation[i] is the new position of i-th coordinate
+		dimension_array permutation;
+		FOR_DIMENSION(dim_id) {
+			permutation[dim_id] = dim_id;
+		}
+		automorphism_id permutation_id = 0;
+		do {
+			transformation transform_data;
+			FOR_DIMENSION(dim_id) {
+				transform_data.dim_permutation[dim_id] = (1 << permutation[dim_id]);
+			}
+
+			//Tabulate the transformation for all swaps of coordinates
+			FOR_VERTICES(swap) {
+				transform_data.dim_swap = swap;
+				automorphism_id id = get_id(swap, permutation_id);
+				FOR_VERTICES(vertex_id) {
+					forward_tables[id][vertex_id] = transform_data.apply(vertex_id);
+					inverse_tables[id][vertex_id] = transform_data.apply_inverse(vertex_id);
+				}
+#ifdef _DEBUG
+				FOR_VERTICES(vertex_id) {
+					if (inverse_tables[id][forward_tables[id][vertex_id]] != vertex_id)
+						errors::assert_error("Automorphism tables are corrupted!");
+				}
+#endif //_DEBUG
+			}
+
+			//Register the permutation for all masks mapped onto lowest coordinates
+			FOR_VERTICES(mask) {
+				sfi image = 0;
+				FOR_DIMENSION(dim_id) {
+					if (mask & (1 << dim_id))
+						image ^= (1 << permutation[dim_id]);
+				}
+				if (image == (1 << hamming[mask]) - 1)
+					low_permutations_tables[mask].push_back(permutation_id);
+			}
+			permutation_id++;
+		} while (std::next_permutation(permutation.begin(), permutation.end()));
+
+		return true;
+	}
+
+	std::vector<vertices_array> automorphisms::forward_tables;
+	std::vector<vertices_array> automorphisms::inverse_tables;
+	std::vector<std::vector<automorphism_id>> automorphisms::low_permutations_tables;
+	const bool automorphisms::built = automorphisms::build();
+}
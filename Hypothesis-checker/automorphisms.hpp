@@ -0,0 +1,67 @@
+#ifndef AUTOMORPHISMS_
+#define AUTOMORPHISMS_
+
+#include "settings.hpp"
+#include "errors.hpp"
+#include "transformation.hpp"
+#include <vector>
+#include <algorithm>
+
+namespace cube {
+	//Index of an automorphism in automorphisms tables (16 bits are enough up to dimension 6 and keep lists of automorphisms compact)
+	typedef uint16_t automorphism_id;
+
+	/* Returns n!, usable for compile-time constants. */
+	constexpr llfi factorial(sfi n) {
+		return (n <= 1) ? 1 : n * factorial(n - 1);
+	}
+
+	/* Precomputed tables of all 2^n * n! automorphisms of Q_n stored as vertex permutations (built once at startup).
+	   Automorphism with id swap * PERMUTATIONS_CNT + permutation_id swaps coordinates given by bits of swap and then permutes coordinates by permutation_id-th permutation. */
+	class automorphisms {
+	public:
+		//Number of permutations of coordinates
+		static const llfi PERMUTATIONS_CNT = factorial(DIMENSION);
+
+		//Number of all automorphisms of Q_n
+		static const llfi AUTOMORPHISMS_CNT = VERTICES * PERMUTATIONS_CNT;
+
+		/* Returns id of automorphism composed from swapping coordinates and selected permutation. */
+		static automorphism_id get_id(const sfi swap, const automorphism_id permutation_id) {
+			return (automorphism_id)(swap * PERMUTATIONS_CNT + permutation_id);
+		}
+
+		/* Returns the automorphism as vertex permutation - forward(id)[v] is the image of vertex v. */
+		static const vertices_array & forward(const automorphism_id id) {
+			return forward_tables[id];
+		}
+
+		/* Returns the inverse automorphism - inverse(id)[v] is the vertex which is mapped onto v. */
+		static const vertices_array & inverse(const automorphism_id id) {
+			return inverse_tables[id];
+		}
+
+		/* Returns ids of all permutations which map the coordinates set in mask onto the lowest hamming[mask] coordinates. */
+		static const std::vector<automorphism_id> & low_permutations(const sfi mask) {
+			return low_permutations_tables[mask];
+		}
+
+	private:
+		/* Fills all tables. */
+		static bool build();
+
+		//Vertex permutations of all automorphisms
+		static std::vector<vertices_array> forward_tables;
+
+		//Vertex permutations of all inverse automorphisms
+		static std::vector<vertices_array> inverse_tables;
+
+		//For every mask of coordinates list of permutations mapping it onto lowest coordinates
+		static std::vector<std::vector<automorphism_id>> low_permutations_tables;
+
+		//Set after the tables are built
+		static const bool built;
+	};
+}
+
+#endif //AUTOMORPHISMS_
@@ -0,0 +1,41 @@
+#include "benchmark.hpp"
+
+namespace cube {
+	void benchmark::insert_throughput(size_t max_threads) {
+		std::cout << "Concurrent insert benchmark (" << INSERTS_CNT << " inserts, " << INSERTS_CNT / 2 << " distinct values)" << std::endl;
+		//Powers of two up to max_threads
+		std::vector<size_t> thread_counts;
+		for (size_t threads = 1; threads < max_threads; threads *= 2) {
+			thread_counts.push_back(threads);
+		}
+		thread_counts.push_back(max_threads);
+
+		for (size_t count_id = 0; count_id < thread_counts.size(); count_id++) {
+			size_t threads = thread_counts[count_id];
+			concurrent_result_set set;
+			std::vector<std::thread> workers;
+			auto start = std::chrono::steady_clock::now();
+			for (size_t thread_id = 0; thread_id < threads; thread_id++) {
+				llfi begin = INSERTS_CNT * thread_id / threads;
+				llfi end = INSERTS_CNT * (thread_id + 1) / threads;
+				workers.push_back(std::thread([&set, begin, end]() { insert_range(set, begin, end); }));
+			}
+			for (size_t thread_id = 0; thread_id < workers.size(); thread_id++) {
+				workers[thread_id].join();
+			}
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			if (set.size() != INSERTS_CNT / 2)
+				errors::assert_error("Concurrent inserts lost some values!");
+			std::cout << "Threads: " << threads << ", time: " << seconds << " s, inserts per second: " << (llfi)(INSERTS_CNT / seconds)
+				<< ", contentions: " << set.total_contentions() << std::endl;
+		}
+	}
+
+	void benchmark::insert_range(concurrent_result_set & set, llfi begin, llfi end) {
+		for (llfi value_id = begin; value_id < end; value_id++) {
+			//Values from both halves of the range are same, mixing spreads them over the whole set (and never gives 0)
+			set.insert(mix_hash(value_id % (INSERTS_CNT / 2) + 1));
+		}
+	}
+}
\ No newline at end of file
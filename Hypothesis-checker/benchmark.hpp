@@ -0,0 +1,28 @@
+#ifndef BENCHMARK_
+#define BENCHMARK_
+
+#include "settings.hpp"
+#include "errors.hpp"
+#include "containers.hpp"
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <iostream>
+
+namespace cube {
+	/* Benchmarks of shared data structures, run instead of the checker when selected by arguments. */
+	class benchmark {
+	public:
+		/* Measures throughput of concurrent_result_set inserts for 1, 2, 4, ... up to max_threads threads and writes it to std::cout. */
+		static void insert_throughput(size_t max_threads);
+
+	private:
+		//Number of inserts in one measurement, every value is inserted twice (by different threads when there are more of them)
+		static const llfi INSERTS_CNT = 1 << 23;
+
+		/* Inserts values with ids [begin, end) into the set. */
+		static void insert_range(concurrent_result_set & set, llfi begin, llfi end);
+	};
+}
+
+#endif //BENCHMARK_
\ No newline at end of file
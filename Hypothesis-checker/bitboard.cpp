@@ -0,0 +1,162 @@
+#include "bitboard.hpp"
+
+namespace cube {
+	const std::array<vertices_mask, 6> bitboard_solver::LOWER_HALF = {
+		0x5555555555555555ULL & ALL_VERTICES,
+		0x3333333333333333ULL & ALL_VERTICES,
+		0x0f0f0f0f0f0f0f0fULL & ALL_VERTICES,
+		0x00ff00ff00ff00ffULL & ALL_VERTICES,
+		0x0000ffff0000ffffULL & ALL_VERTICES,
+		0x00000000ffffffffULL & ALL_VERTICES
+	};
+
+	void bitboard_solver::prepare(const perfect_matching & matching) {
+		//Every edge of the matching is a component with its vertices as endpoints
+		base_closing.fill(0);
+		FOR_VERTICES(vertex_id) {
+			sfi neighbour = matching[vertex_id];
+			base_other_end[vertex_id] = neighbour;
+			if (hamming[vertex_id ^ neighbour] == 1)
+				base_closing[top_one[vertex_id ^ neighbour]] |= (vertices_mask)1 << vertex_id;
+		}
+	}
+
+	void bitboard_solver::solve(path & solved_path) {
+		actual_path = &solved_path;
+		external = ALL_VERTICES;
+		other_end = base_other_end;
+		closing = base_closing;
+		solved_path.found_path.fill(INVALID);
+		history_cnt = 0;
+		//adding "edge" start_vertex->end_vertex (simulates that start_vertex and end_vertex are not connectable)
+		add_edge(solved_path.start_vertex, solved_path.end_vertex);
+		choose_next(0);
+	}
+
+	void bitboard_solver::count_possibilities(possibilities & actual) const {
+		actual.count_bits.fill(0);
+		FOR_DIMENSION(dim) {
+			//Both vertices of the edge have to be external and they must not close a cycle
+			vertices_mask edges = external & flip(external, dim) & ~closing[dim];
+			actual.edges[dim] = edges;
+			//Add the edges to the counter
+			vertices_mask carry = edges;
+			for (sfi bit = 0; bit < 3; bit++) {
+				vertices_mask next_carry = actual.count_bits[bit] & carry;
+				actual.count_bits[bit] ^= carry;
+				carry = next_carry;
+			}
+		}
+	}
+
+	void bitboard_solver::add_edge(sfi first_vertex, sfi second_vertex) {
+		edge_record & record = history[history_cnt++];
+		record.first_vertex = first_vertex;
+		record.second_vertex = second_vertex;
+		record.first_end = other_end[first_vertex];
+		record.second_end = other_end[second_vertex];
+#ifdef _DEBUG
+		//Check that adding this edge is valid
+		if (record.first_end == second_vertex)
+			errors::assert_error("Chosen edge would connect same components!");
+		if (!(external & ((vertices_mask)1 << first_vertex)) || !(external & ((vertices_mask)1 << second_vertex)))
+			errors::assert_error("Chosen vertex is not external!");
+#endif //_DEBUG
+
+		//The other endpoints of both components are the endpoints of the merged component
+		other_end[record.first_end] = record.second_end;
+		other_end[record.second_end] = record.first_end;
+		if (hamming[record.first_end ^ record.second_end] == 1)
+			closing[top_one[record.first_end ^ record.second_end]] |= ((vertices_mask)1 << record.first_end) | ((vertices_mask)1 << record.second_end);
+		external &= ~(((vertices_mask)1 << first_vertex) | ((vertices_mask)1 << second_vertex));
+		actual_path->found_path[first_vertex] = second_vertex;
+		actual_path->found_path[second_vertex] = first_vertex;
+	}
+
+	void bitboard_solver::remove_edge() {
+		const edge_record & record = history[--history_cnt];
+		//The endpoints of the merged component were not endpoints of the same component before
+		if (hamming[record.first_end ^ record.second_end] == 1)
+			closing[top_one[record.first_end ^ record.second_end]] &= ~(((vertices_mask)1 << record.first_end) | ((vertices_mask)1 << record.second_end));
+		other_end[record.first_end] = record.first_vertex;
+		other_end[record.second_end] = record.second_vertex;
+		external |= ((vertices_mask)1 << record.first_vertex) | ((vertices_mask)1 << record.second_vertex);
+		actual_path->found_path[record.first_vertex] = INVALID;
+		actual_path->found_path[record.second_vertex] = INVALID;
+	}
+
+	void bitboard_solver::choose_next(sfi edges_added) {
+		nodes_++;
+		//If done except the last edge, check it and then finish the path with it.
+		if (edges_added == MATCH_SIZE - 2) {
+			sfi first_external = lowest_bit(external);
+			sfi second_external = lowest_bit(external & (external - 1));
+			if (hamming[first_external ^ second_external] == 1) {
+				actual_path->found_path[first_external] = second_external;
+				actual_path->found_path[second_external] = first_external;
+				actual_path->has_solution = true;
+			}
+			return;
+		}
+
+		possibilities actual;
+		count_possibilities(actual);
+#ifdef FORWARD_CHECKING
+		//Vertices with single possibility are connected in increasing order (each of them with respect to the edges added before), a vertex without any possibility ends the search
+		sfi forced_cnt = 0;
+		bool dead_end = false;
+		vertices_mask scanned = 0;
+		while (edges_added + forced_cnt < MATCH_SIZE - 2) {
+			vertices_mask constrained = (with_count(actual, 0) | with_count(actual, 1)) & ~scanned;
+			if (constrained == 0)
+				break;
+			sfi vertex_id = lowest_bit(constrained);
+			vertices_mask vertex_bit = (vertices_mask)1 << vertex_id;
+			if (with_count(actual, 0) & vertex_bit) {
+				dead_end = true;
+				break;
+			}
+			sfi dim = 0;
+			while (!(actual.edges[dim] & vertex_bit))
+				dim++;
+			add_edge(vertex_id, vertex_id ^ (1 << dim));
+			forced_cnt++;
+			scanned |= (vertex_bit << 1) - 1;
+			count_possibilities(actual);
+		}
+		//The state was changed by forced edges, continue with a new scan
+		if (dead_end || forced_cnt > 0) {
+			if (!dead_end)
+				choose_next(edges_added + forced_cnt);
+			//If not done, remove the forced edges again
+			if (!actual_path->has_solution) {
+				for (sfi forced_id = 0; forced_id < forced_cnt; forced_id++) {
+					remove_edge();
+				}
+			}
+			return;
+		}
+#endif //FORWARD_CHECKING
+		//find the most constrained vertex (the lowest one of them)
+		sfi best_vertex = 0;
+		for (sfi count = 0; count < DIMENSION; count++) {
+			vertices_mask candidates = with_count(actual, count);
+			if (candidates != 0) {
+				best_vertex = lowest_bit(candidates);
+				break;
+			}
+		}
+		//Try to match it with all possible neighbours
+		vertices_mask best_bit = (vertices_mask)1 << best_vertex;
+		FOR_DIMENSION(dim) {
+			if (actual.edges[dim] & best_bit) {
+				add_edge(best_vertex, best_vertex ^ (1 << dim));
+				choose_next(edges_added + 1);
+				//If done, propagate result
+				if (actual_path->has_solution)
+					return;
+				remove_edge();
+			}
+		}
+	}
+}
@@ -0,0 +1,110 @@
+#ifndef BITBOARD_
+#define BITBOARD_
+
+#include "settings.hpp"
+#include "path.hpp"
+#include "errors.hpp"
+#include <array>
+
+namespace cube {
+	/* Alternative engine of the Hamiltonian path search with the same strategy (and the same results) as pathfinding::solve, but its state is stored as bitboards.
+	   The possible edges are not stored at all - the edge v->v^(1<<dim) is possible iff both vertices are external and they are not the endpoints of the same component,
+	   thus the possible edges of all vertices in one dimension are computed by a few mask operations and the numbers of possibilities of all vertices at once by a bit-sliced counter. */
+	class bitboard_solver {
+	public:
+		/* Creates empty solver. */
+		bitboard_solver() : nodes_(0) {}
+
+		/* Prepares the data used for search of all pairs of ending vertices of given matching. */
+		void prepare(const perfect_matching & matching);
+
+		/* Tries to find Hamiltonian path for the matching (it has to be prepared) and ending vertices of given path, found_path and has_solution are filled in the same way as by pathfinding::solve. */
+		void solve(path & actual_path);
+
+		/* Returns the number of nodes of the search expanded so far. */
+		llfi nodes() const {
+			return nodes_;
+		}
+
+	private:
+		/* Numbers of possibilities of all external vertices stored as bit-sliced counter - bit v of count_bits[i] is i-th bit of the number of possibilities of vertex v. */
+		struct possibilities {
+			//Masks of possible edges in every dimension
+			std::array<vertices_mask, DIMENSION> edges;
+			//Bits of the counter
+			std::array<vertices_mask, 3> count_bits;
+		};
+
+		/* Information needed to undo an added edge. */
+		struct edge_record {
+			//The edge
+			sfi first_vertex;
+			sfi second_vertex;
+			//The other endpoints of components of both vertices (they become the endpoints of the merged component)
+			sfi first_end;
+			sfi second_end;
+		};
+
+		/* Returns mask of vertices u such that the vertex u^(1<<dim) is in given mask. */
+		static vertices_mask flip(vertices_mask mask, sfi dim) {
+			return ((mask & LOWER_HALF[dim]) << (1 << dim)) | ((mask >> (1 << dim)) & LOWER_HALF[dim]);
+		}
+
+		/* Returns mask of all vertices with given number of possibilities (a single bit of external vertices with the number is not sufficient). */
+		vertices_mask with_count(const possibilities & actual, sfi count) const {
+			vertices_mask result = external;
+			for (sfi bit = 0; bit < 3; bit++) {
+				result &= (count & (1 << bit)) ? actual.count_bits[bit] : ~actual.count_bits[bit];
+			}
+			return result;
+		}
+
+		/* Computes the possible edges and the numbers of possibilities of all vertices. */
+		void count_possibilities(possibilities & actual) const;
+
+		/* Adds selected edge to partial path and properly actualizes search data. */
+		void add_edge(sfi first_vertex, sfi second_vertex);
+
+		/* Removes the last added edge from partial path. */
+		void remove_edge();
+
+		/* Tries to recursively find edges from Q_n to complete the path, see pathfinding::choose_next. */
+		void choose_next(sfi edges_added);
+
+		//Masks of vertices with zero bit in given dimension
+		static const std::array<vertices_mask, 6> LOWER_HALF;
+
+		//Mask of all vertices
+		static const vertices_mask ALL_VERTICES = (VERTICES == 64) ? ~(vertices_mask)0 : ((vertices_mask)1 << (VERTICES & 63)) - 1;
+
+
+		/* Used data structures: */
+
+		/* The path which is solved. */
+		path * actual_path;
+
+		/* Mask of external vertices (vertices without an edge of partial path). */
+		vertices_mask external;
+
+		/* The other endpoint of the component of partial path, valid for external vertices only. */
+		vertices_array other_end;
+
+		/* Masks of external vertices which are the endpoints of the same component with their neighbour in given dimension (valid for external vertices only). */
+		std::array<vertices_mask, DIMENSION> closing;
+
+		/* other_end and closing of actual matching before the ending vertices are connected. */
+		vertices_array base_other_end;
+		std::array<vertices_mask, DIMENSION> base_closing;
+
+		/* Stack of added edges. */
+		std::array<edge_record, MATCH_SIZE> history;
+
+		/* Number of edges in history. */
+		sfi history_cnt;
+
+		/* Number of expanded nodes of the search. */
+		llfi nodes_;
+	};
+}
+
+#endif //BITBOARD_
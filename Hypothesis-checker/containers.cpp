@@ -2,19 +2,192 @@
 
 namespace cube {
 	bool result_set::insert(llfi value) {
-		llfi index = value % PRIME_MOD;
-		if (std::find(data[index].cbegin(), data[index].cend(), value) == data[index].cend()) {
-			data[index].push_back(value);
-			size_++;
-			return true;
+		if (is_flat())
+			errors::assert_error("The flat container is read-only!");
+		llfi hash_value = mix_hash(value);
+		return insert_into(data[block_id(hash_value)], hash_value, true);
+	}
+
+	void result_set::insert_unique(llfi value) {
+		if (is_flat())
+			errors::assert_error("The flat container is read-only!");
+		llfi hash_value = mix_hash(value);
+		insert_into(data[block_id(hash_value)], hash_value, false);
+	}
+
+	bool result_set::contains(llfi value) const {
+		if (is_flat())
+			return std::find(flat.begin(), flat.end(), value) != flat.end();
+		llfi hash_value = mix_hash(value);
+		const block & target = data[block_id(hash_value)];
+		if (target.capacity == 0)
+			return false;
+		//The value may be only in the run of values with lower or equal order key starting at its home slot
+		for (llfi slot = home_slot(hash_value, target.capacity); slot < target.slots.size(); slot++) {
+			llfi actual = target.slots[slot];
+			if (actual == hash_value)
+				return true;
+			if (actual == 0 || order_key(actual) > order_key(hash_value))
+				return false;
 		}
 		return false;
 	}
 
+	void result_set::assign_flat(std::vector<llfi> && values) {
+		clear();
+		flat.swap(values);
+	}
+
 	void result_set::clear() {
+		std::vector<llfi>().swap(flat);
+		for (llfi index = 0; index < data.size(); index++) {
+			std::vector<llfi>().swap(data[index].slots);
+			data[index].capacity = 0;
+			data[index].size = 0;
+		}
+	}
+
+	llfi result_set::size() const {
+		if (is_flat())
+			return flat.size();
+		llfi total = 0;
 		for (llfi index = 0; index < data.size(); index++) {
-			data[index].clear();
+			total += data[index].size;
 		}
+		return total;
+	}
+
+	bool result_set::insert_into(block & target, llfi hash_value, bool check_duplicity) {
+		if ((target.size + 1) * MAX_LOAD_DEN > target.capacity * MAX_LOAD_NUM)
+			grow(target);
+
+		llfi slot = home_slot(hash_value, target.capacity);
+		//Find the place of the value in the sorted run
+		for (; slot < target.slots.size() && target.slots[slot] != 0; slot++) {
+			llfi actual = target.slots[slot];
+			if (check_duplicity && actual == hash_value)
+				return false;
+			if (order_key(actual) > order_key(hash_value))
+				break;
+		}
+		//Shift the rest of the run by one slot
+		llfi empty_slot = slot;
+		while (empty_slot < target.slots.size() && target.slots[empty_slot] != 0)
+			empty_slot++;
+		if (empty_slot == target.slots.size()) {
+			//The run reaches the end of the table, so the value is inserted after growth
+			grow(target);
+			insert_into(target, hash_value, false);
+			return true;
+		}
+		std::move_backward(target.slots.begin() + slot, target.slots.begin() + empty_slot, target.slots.begin() + empty_slot + 1);
+		target.slots[slot] = hash_value;
+		target.size++;
+		return true;
+	}
+
+	void result_set::grow(block & target) {
+		llfi new_capacity = std::max(INITIAL_CAPACITY, target.capacity * GROWTH_NUM / GROWTH_DEN);
+		while (!rebuild(target, new_capacity)) {
+			new_capacity = new_capacity * GROWTH_NUM / GROWTH_DEN;
+		}
+	}
+
+	bool result_set::rebuild(block & target, llfi new_capacity) {
+		std::vector<llfi> grown(new_capacity + spare_slots(new_capacity), 0);
+		//The values are sorted by the order key, so their new home slots are sorted too and each of them is placed to its home or right after the previous one
+		llfi next_slot = 0;
+		for (llfi slot = 0; slot < target.slots.size(); slot++) {
+			llfi actual = target.slots[slot];
+			if (actual != 0) {
+				llfi new_slot = std::max(home_slot(actual, new_capacity), next_slot);
+				if (new_slot >= grown.size())
+					return false;
+				grown[new_slot] = actual;
+				next_slot = new_slot + 1;
+			}
+		}
+		target.slots.swap(grown);
+		target.capacity = new_capacity;
+		return true;
+	}
+
+	bool concurrent_result_set::insert(llfi value) {
+		llfi hash_value = mix_hash(value);
+		bool is_new = result_set::insert_into(lock_block(hash_value), hash_value, true);
+		shards[result_set::block_id(hash_value)].lock.unlock();
+		if (is_new)
+			size_++;
+		return is_new;
+	}
+
+	void concurrent_result_set::insert_unique(llfi value) {
+		llfi hash_value = mix_hash(value);
+		result_set::insert_into(lock_block(hash_value), hash_value, false);
+		shards[result_set::block_id(hash_value)].lock.unlock();
+		size_++;
+	}
+
+	void concurrent_result_set::clear() {
+		set.clear();
+		for (llfi shard_id = 0; shard_id < shards.size(); shard_id++) {
+			shards[shard_id].contentions = 0;
+		}
+		size_ = 0;
+	}
+
+	llfi concurrent_result_set::total_contentions() const {
+		llfi total = 0;
+		for (llfi shard_id = 0; shard_id < shards.size(); shard_id++) {
+			total += shards[shard_id].contentions;
+		}
+		return total;
+	}
+
+	result_set concurrent_result_set::release() {
+		result_set released;
+		std::swap(released.data, set.data);
 		size_ = 0;
+		return released;
+	}
+
+	result_set::block & concurrent_result_set::lock_block(llfi hash_value) {
+		llfi block_id = result_set::block_id(hash_value);
+		shard & actual = shards[block_id];
+		if (!actual.lock.try_lock()) {
+			actual.contentions++;
+			actual.lock.lock();
+		}
+		return set.data[block_id];
+	}
+
+	void result_set_builder::add(llfi chunk_id, const llfi * first, const llfi * last) {
+		std::vector<llfi> * chunk_pieces = pieces.data() + chunk_id * result_set::BLOCKS_CNT;
+		for (const llfi * value = first; value != last; value++) {
+			llfi hash_value = mix_hash(*value);
+			chunk_pieces[result_set::block_id(hash_value)].push_back(hash_value);
+		}
+	}
+
+	void result_set_builder::build(llfi block_id) {
+		std::vector<llfi> hashes;
+		for (llfi piece_id = block_id; piece_id < pieces.size(); piece_id += result_set::BLOCKS_CNT) {
+			hashes.insert(hashes.end(), pieces[piece_id].begin(), pieces[piece_id].end());
+			std::vector<llfi>().swap(pieces[piece_id]);
+		}
+		//The slots are sorted by the order key, equal hashes are neighbours then
+		std::sort(hashes.begin(), hashes.end(), [](llfi first, llfi second) {
+			return result_set::order_key(first) < result_set::order_key(second) || (result_set::order_key(first) == result_set::order_key(second) && first < second);
+		});
+		hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+		//The sorted hashes are placed into the table with the load of one growth step below the maximal load
+		result_set::block & target = set.data[block_id];
+		llfi capacity = std::max(result_set::INITIAL_CAPACITY, (llfi)hashes.size() * result_set::MAX_LOAD_DEN / result_set::MAX_LOAD_NUM * result_set::GROWTH_NUM / result_set::GROWTH_DEN + 1);
+		target.size = hashes.size();
+		target.slots.swap(hashes);
+		while (!result_set::rebuild(target, capacity)) {
+			capacity = capacity * result_set::GROWTH_NUM / result_set::GROWTH_DEN;
+		}
 	}
-}
\ No newline at end of file
+}
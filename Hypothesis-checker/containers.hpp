@@ -5,50 +5,319 @@
 #include "errors.hpp"
 #include <vector>
 #include <algorithm>
+#include <mutex>
+#include <atomic>
 
 namespace cube {
-	//The size of the container is reduced in DEBUG mode due to memory consumption
-#ifdef _DEBUG
-	static const llfi PRIME_MOD = 100267;
-#else
-	static const llfi PRIME_MOD = 10000357;
-#endif //_DEBUG
-
-	/* User-defined mini-container made for holding generated matchings in very comprimed state to spare memory consumption*/
+	/* 64-bit mixing function (finalizer of MurmurHash3), compressed matchings have very regular bits so they have to be mixed well.
+	   The function is a bijection which maps 0 to 0, thus result_set stores the mixed values directly and never has to recompute them. */
+	inline llfi mix_hash(llfi value) {
+		value ^= value >> 33;
+		value *= 0xff51afd7ed558ccdULL;
+		value ^= value >> 33;
+		value *= 0xc4ceb9fe1a85ec53ULL;
+		value ^= value >> 33;
+		return value;
+	}
+
+	/* Inverse function of mix_hash. */
+	inline llfi unmix_hash(llfi value) {
+		value ^= value >> 33;
+		value *= 0x9cb4b2f8129337dbULL;
+		value ^= value >> 33;
+		value *= 0x4f74430c22a54005ULL;
+		value ^= value >> 33;
+		return value;
+	}
+
+	/* Read-only view of one block of result_set. Iteration skips the empty slots, thus only the stored values are visited. */
+	class result_block {
+	public:
+		/* Forward iterator over stored values of the block. */
+		class iterator {
+		public:
+			iterator(const llfi * position, const llfi * end, bool mixed) : position(position), end(end), mixed(mixed) {
+				skip_empty();
+			}
+
+			llfi operator*() const {
+				return mixed ? unmix_hash(*position) : *position;
+			}
+
+			iterator & operator++() {
+				position++;
+				skip_empty();
+				return *this;
+			}
+
+			iterator operator++(int) {
+				iterator old = *this;
+				++(*this);
+				return old;
+			}
+
+			bool operator==(const iterator & other) const {
+				return position == other.position;
+			}
+
+			bool operator!=(const iterator & other) const {
+				return position != other.position;
+			}
+
+		private:
+			/* Moves the iterator to the next non-empty slot (or to the end). */
+			void skip_empty() {
+				while (position != end && *position == 0)
+					position++;
+			}
+
+			//Actual slot
+			const llfi * position;
+
+			//End of the block slots
+			const llfi * end;
+
+			//Whether the slots hold mix_hash of the values (otherwise the values themselves)
+			bool mixed;
+		};
+
+		/* Creates a view of given slots, which hold mix_hash of the values if mixed is true (otherwise the values themselves). */
+		result_block(const llfi * first, const llfi * last, bool mixed = true) : first(first), last(last), mixed(mixed) {}
+
+		iterator begin() const {
+			return iterator(first, last, mixed);
+		}
+
+		iterator end() const {
+			return iterator(last, last, mixed);
+		}
+
+		/* Returns the view of slots [begin, end) of this block (used to split the block into smaller pieces of work). */
+		result_block slice(llfi begin, llfi end) const {
+			return result_block(first + std::min(begin, slots()), first + std::min(end, slots()), mixed);
+		}
+
+		/* Returns number of stored values in the block. */
+		llfi size() const {
+			return slots() - std::count(first, last, 0);
+		}
+
+		/* Returns number of slots of the block (both empty and used). */
+		llfi slots() const {
+			return last - first;
+		}
+
+	private:
+		//Slots of the block
+		const llfi * first;
+		const llfi * last;
+
+		//Whether the slots hold mix_hash of the values
+		bool mixed;
+	};
+
+	/* User-defined mini-container made for holding generated matchings in very comprimed state to spare memory consumption.
+	   It is a hash set of non-zero 64-bit numbers (0 is never a valid compressed matching, so it marks empty slots) stored as their mix_hash, split into BLOCKS_CNT independent blocks.
+	   Each block is a flat open-addressing table with linear probing (without wrap-around, there are few spare slots at its end) whose slots are kept sorted by the lower 32 bits of the hash,
+	   thus growth of a block is a single sequential pass and only one block is rebuilt at once.
+	   Matchings loaded from a trusted file are kept as a flat array instead (no hashing, no empty slots), which is split evenly into the blocks and which is read-only. */
 	class result_set {
 	public:
+		//Number of independent blocks, selected by the top bits of the hash
+		static const llfi BLOCKS_CNT = 256;
+
 		/* Default constructor */
-		result_set() : data(std::vector<std::vector<llfi>>(PRIME_MOD)) {}
+		result_set() : data(BLOCKS_CNT) {}
 
-		/* Tries to insert given 64-bit number (comprimed matching) into container. 
+		/* Tries to insert given 64-bit number (comprimed matching) into container.
 		   Returns true if the element was not there, otherwise returns false and the element is not inserted. */
-		bool insert(llfi value); 
+		bool insert(llfi value);
+
+		/* Inserts given 64-bit number which is guaranteed not to be in container yet (no check is done). */
+		void insert_unique(llfi value);
+
+		/* Returns whether given 64-bit number is in the container. */
+		bool contains(llfi value) const;
+
+		/* Replaces the content of the container by given distinct values, which are kept as a flat array (no insert is allowed then and contains is linear). */
+		void assign_flat(std::vector<llfi> && values);
+
+		/* Returns whether the container is a flat array. */
+		bool is_flat() const {
+			return !flat.empty();
+		}
 
-		/* Clears the container. */
+		/* Clears the container and releases its memory. */
 		void clear();
 
 		/* Returns container size. */
-		llfi size() {
+		llfi size() const;
+
+		/* Returns number of blocks of the container. */
+		llfi block_count() const {
+			return BLOCKS_CNT;
+		}
+
+		/* Returns view of given block of data in container. */
+		result_block operator[](llfi block_id) const {
+			if (is_flat())
+				return result_block(flat.data() + flat.size() * block_id / BLOCKS_CNT, flat.data() + flat.size() * (block_id + 1) / BLOCKS_CNT, false);
+			return result_block(data[block_id].slots.data(), data[block_id].slots.data() + data[block_id].slots.size());
+		}
+
+	private:
+		/* Single open-addressing table. */
+		struct block {
+			//Slots of the table (mixed values), 0 marks an empty slot
+			std::vector<llfi> slots;
+
+			//Number of home slots, the rest of slots is a spare space for values from the last home slots
+			llfi capacity = 0;
+
+			//Number of used slots
+			llfi size = 0;
+		};
+
+		//Capacity of a block when the first element is inserted
+		static const llfi INITIAL_CAPACITY = 64;
+
+		//Maximal load of a block is MAX_LOAD_NUM / MAX_LOAD_DEN, after that the block grows
+		static const llfi MAX_LOAD_NUM = 9;
+		static const llfi MAX_LOAD_DEN = 10;
+
+		//The block capacity is multiplied by GROWTH_NUM / GROWTH_DEN when it grows (small factor keeps the memory usage low)
+		static const llfi GROWTH_NUM = 9;
+		static const llfi GROWTH_DEN = 8;
+
+		/* Returns the block for given hash. */
+		static llfi block_id(llfi hash_value) {
+			return (hash_value >> 56) & (BLOCKS_CNT - 1);
+		}
+
+		/* Returns the key by which the slots are sorted. */
+		static llfi order_key(llfi hash_value) {
+			return hash_value & 0xffffffffULL;
+		}
+
+		/* Returns the home slot of given hash in table of given capacity (multiply-shift range reduction of the order key, so the home slots are sorted as well). */
+		static llfi home_slot(llfi hash_value, llfi capacity) {
+			return (order_key(hash_value) * capacity) >> 32;
+		}
+
+		/* Returns the number of spare slots at the end of table with given capacity. */
+		static llfi spare_slots(llfi capacity) {
+			return (capacity >> 6) + 64;
+		}
+
+		/* Inserts the hash of a value into the block, if check_duplicity is true and the hash is there already, nothing is done. Returns whether the hash was inserted. */
+		static bool insert_into(block & target, llfi hash_value, bool check_duplicity);
+
+		/* Rebuilds the block with larger capacity. */
+		static void grow(block & target);
+
+		/* Moves all values of the block into new table of given capacity in one pass. Returns false (and keeps the block unchanged) if the spare slots are not sufficient. */
+		static bool rebuild(block & target, llfi new_capacity);
+
+		//Blocks of the container
+		std::vector<block> data;
+
+		//Values of the flat container (empty otherwise)
+		std::vector<llfi> flat;
+
+		//The concurrent variant and the builder work directly with the blocks
+		friend class concurrent_result_set;
+		friend class result_set_builder;
+	};
+
+	/* Builder of result_set from large arrays of values (e. g. a mapped file) by several threads. The hashes of every chunk of values are split by the blocks
+	   and then every block is sorted and placed in one pass, thus no lock is needed and no block is rebuilt by the growth. */
+	class result_set_builder {
+	public:
+		/* Creates builder for given number of chunks of values. */
+		explicit result_set_builder(llfi chunks_cnt) : pieces(chunks_cnt * result_set::BLOCKS_CNT) {}
+
+		/* Adds values of given chunk (duplicities are allowed), different chunks may be added by several threads at once. */
+		void add(llfi chunk_id, const llfi * first, const llfi * last);
+
+		/* Builds given block of the set from the values of all chunks (all of them have to be added), different blocks may be built by several threads at once. */
+		void build(llfi block_id);
+
+		/* Moves the set out (all blocks have to be built). */
+		result_set release() {
+			return std::move(set);
+		}
+
+	private:
+		//Hashes of values of every chunk split by the blocks (pieces[chunk_id * BLOCKS_CNT + block_id])
+		std::vector<std::vector<llfi>> pieces;
+
+		//The built set
+		result_set set;
+	};
+
+	/* Thread-safe variant of result_set used when many threads insert at once. The blocks of result_set are selected by the hash, thus they serve as shards:
+	   every block is guarded by its own lock, so threads inserting into different blocks never wait for each other and there is no global lock. */
+	class concurrent_result_set {
+	public:
+		/* Default constructor */
+		concurrent_result_set() : shards(result_set::BLOCKS_CNT), size_(0) {}
+
+		/* Tries to insert given 64-bit number (comprimed matching) into container, may be called by several threads at once.
+		   Returns true if the element was not there, otherwise returns false and the element is not inserted. */
+		bool insert(llfi value);
+
+		/* Inserts given 64-bit number which is guaranteed not to be in container yet (no check is done), may be called by several threads at once. */
+		void insert_unique(llfi value);
+
+		/* Clears the container and the contention counters (no insert may run meanwhile). */
+		void clear();
+
+		/* Returns container size. */
+		llfi size() const {
 			return size_;
 		}
-		
-		/* Returns reference to given block of data in container. */
-		const std::vector<llfi>& operator[](llfi block_id) const {
-			return data[block_id];
+
+		/* Returns number of shards of the container. */
+		llfi shard_count() const {
+			return shards.size();
 		}
 
-		/* Returns reference to given block of data in container. */
-		std::vector<llfi>& operator[](llfi block_id) {
-			return data[block_id];
+		/* Returns how many times an insert had to wait for the lock of given shard. */
+		llfi contentions(llfi shard_id) const {
+			return shards[shard_id].contentions;
 		}
 
+		/* Returns how many times an insert had to wait for a lock. */
+		llfi total_contentions() const;
+
+		/* Moves the stored elements out as an ordinary result_set (no insert may run meanwhile), the container is left empty. */
+		result_set release();
+
 	private:
-		/* The major container data structure - It is a PRIME_MOD-long array of vectors.
-		   When new element e is about to be inserted into container, The number e % PRIME_MOD is counted and e is inserted into data[e] (if it does not exist yet)*/
-		std::vector<std::vector<llfi>> data;
+		/* Lock of a single block with its statistics. */
+		struct shard {
+			shard() : contentions(0) {}
+
+			std::mutex lock;
+
+			//Number of inserts which found the lock locked
+			std::atomic<llfi> contentions;
+
+			//Locks of neighbouring shards should not share a cache line
+			char padding[64];
+		};
+
+		/* Locks the shard of given hash and returns the block guarded by it. */
+		result_set::block & lock_block(llfi hash_value);
+
+		//The set itself
+		result_set set;
+
+		//Locks of the blocks
+		std::vector<shard> shards;
 
 		//Internal size counter
-		llfi size_ = 0;
+		std::atomic<llfi> size_;
 	};
 }
 
@@ -0,0 +1,56 @@
+#include "cost_model.hpp"
+
+namespace cube {
+	cost_model::features cost_model::extract(const perfect_matching & matching, bool all_parallel, size_t stabilizer_size) {
+		features result;
+		result.free_edges = 0;
+		result.all_parallel = all_parallel;
+		result.dimension_edges.fill(0);
+		result.stabilizer_size = stabilizer_size;
+		FOR_VERTICES(vertex_id) {
+			if (matching[vertex_id] > vertex_id) {
+				sfi edge_dim = vertex_id ^ matching[vertex_id];
+				if (hamming[edge_dim] != 1)
+					result.free_edges++;
+				else {
+					sfi dim = 0;
+					while ((1 << dim) != edge_dim)
+						dim++;
+					result.dimension_edges[dim]++;
+				}
+			}
+		}
+		return result;
+	}
+
+	double cost_model::estimate(const features & matching_features) {
+		sfi largest_dimension = 0;
+		for (sfi dim = 0; dim < DIMENSION; dim++) {
+			largest_dimension = std::max(largest_dimension, matching_features.dimension_edges[dim]);
+		}
+		double log_cost = COST_BASE + COST_FREE_EDGE * matching_features.free_edges + COST_LARGEST_DIMENSION * largest_dimension;
+		if (matching_features.all_parallel)
+			log_cost += COST_ALL_PARALLEL;
+#ifdef SYMMETRY_REDUCTION
+		//Only one pair of every orbit is searched
+		log_cost += COST_STABILIZER * std::log2((double)matching_features.stabilizer_size);
+#endif //SYMMETRY_REDUCTION
+		return std::exp2(log_cost);
+	}
+
+	void cost_model::write_log_header(std::ostream & log) {
+		log << "index;matching;free_edges;all_parallel;";
+		for (sfi dim = 0; dim < DIMENSION; dim++) {
+			log << "dimension_" << (size_t)dim << ";";
+		}
+		log << "stabilizer;estimate;nodes" << std::endl;
+	}
+
+	void cost_model::write_log_line(std::ostream & log, llfi matching_index, llfi compressed_matching, const features & matching_features, llfi nodes) {
+		log << matching_index << ";" << compressed_matching << ";" << (size_t)matching_features.free_edges << ";" << matching_features.all_parallel << ";";
+		for (sfi dim = 0; dim < DIMENSION; dim++) {
+			log << (size_t)matching_features.dimension_edges[dim] << ";";
+		}
+		log << matching_features.stabilizer_size << ";" << estimate(matching_features) << ";" << nodes << "\n";
+	}
+}
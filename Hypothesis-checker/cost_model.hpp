@@ -0,0 +1,42 @@
+#ifndef COST_MODEL_
+#define COST_MODEL_
+
+#include "settings.hpp"
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <ostream>
+
+namespace cube {
+	/* Estimator of the cost of pathfinding of a matching (the number of expanded nodes of the search) from its cheap features, the expensive matchings are solved first.
+	   The logarithm of the cost is a linear function of the features, its coefficients (COST_* in settings.hpp) are fitted to the calibration log written by -l,
+	   which contains the features and the observed number of nodes of every matching. */
+	class cost_model {
+	public:
+		/* Cheap features of a matching. */
+		struct features {
+			//Number of edges of the matching which are not from Q_n
+			sfi free_edges;
+			//Whether all edges of the matching cross the first dimension
+			bool all_parallel;
+			//Numbers of edges from Q_n in every dimension
+			std::array<sfi, DIMENSION> dimension_edges;
+			//Number of automorphisms mapping the matching onto itself
+			size_t stabilizer_size;
+		};
+
+		/* Computes the features of the matching, all_parallel and the size of the stabilizer are already known by the pathfinding. */
+		static features extract(const perfect_matching & matching, bool all_parallel, size_t stabilizer_size);
+
+		/* Returns the estimated number of nodes of the search of a matching with given features. */
+		static double estimate(const features & matching_features);
+
+		/* Writes the header of the calibration log. */
+		static void write_log_header(std::ostream & log);
+
+		/* Writes the line of the calibration log for the matching with given index, compressed form, features and observed number of nodes. */
+		static void write_log_line(std::ostream & log, llfi matching_index, llfi compressed_matching, const features & matching_features, llfi nodes);
+	};
+}
+
+#endif //COST_MODEL_
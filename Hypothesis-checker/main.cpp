@@ -12,7 +12,11 @@ File with entry point of the program.
 #include "matchings.hpp"
 #include "pathfinding.hpp"
 #include "path.hpp"
+#include "path_sink.hpp"
+#include "benchmark.hpp"
+#include "subcube_table.hpp"
 #include <iostream>
+#include <memory>
 
 
 using namespace cube;
@@ -24,20 +28,53 @@ int main(int argc, char ** argv) {
 	std::ios::sync_with_stdio(false); 
 	
 	argument_handler::parse_args(argc, argv);
+
+	//Only the benchmark is run, if it is required
+	if (argument_handler::is_benchmark) {
+		benchmark::insert_throughput(argument_handler::threads);
+		return 0;
+	}
+
+	//Only the binary file of paths is rendered into text, if it is required
+	if (argument_handler::is_path_render) {
+		std::cout << "Rendering paths... ";
+		serializer::render_paths(argument_handler::path_input_file, argument_handler::render_output_file);
+		std::cout << "Done" << std::endl;
+		return 0;
+	}
+
+	//Only the table of subcubes is generated, if it is required
+	if (argument_handler::is_table_output) {
+		std::cout << "Generating table of subcubes... ";
+		subcube_table::generate(argument_handler::table_output_file, argument_handler::threads);
+		std::cout << "Done" << std::endl;
+		return 0;
+	}
+
+	if (argument_handler::is_table_input) {
+		std::cout << "Loading table of subcubes... ";
+		subcube_table::load(argument_handler::table_input_file);
+		std::cout << "Done" << std::endl;
+	}
+
 	result_set & found_matchings = matchings::results;
+	//Whether the matchings are lexicographically minimal (the generated ones are)
+	bool canonical = true;
 
 	//Obtaining perfect matchings, either from file or from generator
 	if (argument_handler::is_input || argument_handler::is_comp_input) {
 		std::cout << "Loading matchings... ";
-		if (argument_handler::is_input)
-			found_matchings = serializer::load_matchings(argument_handler::input_file);
+		if (argument_handler::is_input) {
+			found_matchings = serializer::load_matchings(argument_handler::input_file, argument_handler::is_trusted, argument_handler::threads);
+			canonical = false;
+		}
 		else 
-			found_matchings = serializer::load_comp_matchings(argument_handler::comp_input_file);
+			found_matchings = serializer::load_comp_matchings(argument_handler::comp_input_file, argument_handler::is_trusted, canonical, argument_handler::threads);
 		std::cout << "Done" << std::endl;
 	}
 	else {
 		std::cout << "Generating matchings..." << std::endl;
-		matchings::find_matchings();
+		matchings::find_matchings(argument_handler::threads);
 		std::cout << "Done" << std::endl;
 	}
 	std::cout << "Matchings found: " << found_matchings.size() << std::endl;
@@ -52,49 +89,28 @@ int main(int argc, char ** argv) {
 	//Save them compressed, if it is required
 	if (argument_handler::is_comp_output) {
 		std::cout << "Saving compressed matchings... ";
-		serializer::save_comp_matchings(argument_handler::comp_output_file, found_matchings);
+		serializer::save_comp_matchings(argument_handler::comp_output_file, found_matchings, canonical);
 		std::cout << "Done" << std::endl;
 	}
 
-	//Solve obtained paths
-	std::cout << "Finding paths..." << std::endl;	
-	std::vector<path> found_paths = pathfinding::find_unsolved_paths(found_matchings);
-	std::cout << "Done" << std::endl;
-
-	//Again, save them, if it is required
+	//Solve obtained paths, the results are passed to the summary and saved on the fly, if it is required
+	failure_summary summary;
+	sink_group sinks;
+	sinks.add(summary);
+	std::unique_ptr<path_file_sink> path_file;
 	if (argument_handler::is_path_output) {
-		std::cout << "Saving paths... ";
-		serializer::save_paths(argument_handler::path_output_file, found_paths);
-		std::cout << "Done" << std::endl;
+		path_file.reset(new path_file_sink(argument_handler::path_output_file));
+		sinks.add(*path_file);
 	}
+	//The calibration log is written only if it is required
+	std::string cost_log_file = argument_handler::is_cost_log ? argument_handler::cost_log_file : std::string();
+	std::cout << "Finding paths..." << std::endl;	
+	pathfinding::find_paths(found_matchings, sinks, argument_handler::threads, argument_handler::solver, cost_log_file);
+	if (path_file)
+		path_file->close();
+	std::cout << "Done" << std::endl;
 
 	//Show results
-	std::cout << "Matchings with impossible configurations:" << std::endl;
-	size_t total = 0;
-	size_t solved = found_paths.size() / BIPARTITE_PAIRS_CNT;
-	for (size_t i = 0; i < solved; i++) {
-		size_t failed = 0;
-		for (size_t j = 0; j < BIPARTITE_PAIRS_CNT; j++) {
-			if (!found_paths[i * BIPARTITE_PAIRS_CNT + j].has_solution)
-				failed++;
-		}
-		//Output only matchings with at least one failed path (for clarity)
-		if (failed > 0) {
-			total++;
-			std::cout << "Matching ";
-			std::array<sfi, VERTICES> dimcnts;
-			FOR_VERTICES(vertex_id) {
-				dimcnts[vertex_id] = 0;
-			}
-			FOR_VERTICES(vertex_id) {
-				if (found_paths[i * BIPARTITE_PAIRS_CNT].base_matching[vertex_id] > vertex_id) {
-					dimcnts[vertex_id ^ found_paths[i * BIPARTITE_PAIRS_CNT].base_matching[vertex_id]]++;
-					std::cout << (size_t)vertex_id << "->" << (size_t)found_paths[i * BIPARTITE_PAIRS_CNT].base_matching[vertex_id] << ", ";
-				}
-			}
-			std::cout << "impossible: " << failed << std::endl;
-		}
-	}
-	std::cout << "Total number of matchings with unsolved configurations: " << total << std::endl;
+	summary.print(std::cout);
 	return 0;
 }
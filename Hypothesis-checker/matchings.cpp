@@ -44,6 +44,21 @@ namespace cube {
 		return res;
 	}
 
+	bool is_compressed_matching(llfi compressed_matching) {
+		/* The same process as decompress(), only the used vertices are remembered. */
+		vertices_mask used = 0;
+		for (sfi edge_id = MATCH_SIZE - 1; edge_id != INVALID; edge_id--) {
+			sfi first_empty = lowest_bit(~used);
+			sfi other_vertex = (sfi)(((compressed_matching >> (4 * edge_id)) & (DIMENSION_BITS >> 1)) << 1);
+			if (!(hamming[other_vertex ^ first_empty] & 1))
+				other_vertex ^= 1;
+			if ((used >> other_vertex) & 1)
+				return false;
+			used |= ((vertices_mask)1 << first_empty) | ((vertices_mask)1 << other_vertex);
+		}
+		return true;
+	}
+
 	llfi compress_partial(perfect_matching & source_matching) {
 		sfi edge_cnt = 0;
 		llfi bitmap = 0;
@@ -89,38 +104,75 @@ namespace cube {
 		return result;
 	}
 	
-	void matchings::find_matchings() {
-		clear_matching();
+	void matchings::find_matchings(size_t threads) {
+		//The search is started sequentially up to GENERATOR_SPLIT_DEPTH edges, the remaining subtrees are collected as tasks.
+		std::vector<partial_task> split_tasks;
+		matchings root;
+		root.tasks = &split_tasks;
 		
 		//if there is at least 1 edge from Q_n, there exists an isomorphic matching with edge 0->1.
 		if (HYPER_EDGE_CNT > 0) {
-			hyper_edges = 1;
-			add_edge(0, 1);
-			find_remaining_edges(1, 2);
-			remove_edge(0, 1);
+			root.hyper_edges = 1;
+			root.add_edge(0, 1);
+			root.init_candidates(1, 2);
+			root.find_remaining_edges(1, 2);
+			root.remove_edge(0, 1);
 		}
 
 		//Otherwise, there exist an edge with length 3, alternatively of length 5 for d=5.
 		else {
-			hyper_edges = 0;
-			add_edge(0, 7);
-			find_remaining_edges(1, 1);
-			remove_edge(0, 7);
+			root.hyper_edges = 0;
+			root.add_edge(0, 7);
+			root.init_candidates(1, 1);
+			root.find_remaining_edges(1, 1);
+			root.remove_edge(0, 7);
 
-			clear_matching();
+			root.clear_matching();
 
 			if (DIMENSION == 5) {
 				FOR_EDGES(edge_id) {
-					add_edge(edge_id, DIMENSION_BITS - edge_id);
+					root.add_edge(edge_id, DIMENSION_BITS - edge_id);
 				}
-				results.insert(compress(matching));
+				generated.insert(compress(root.matching));
 			}
-			clear_matching();
+			root.clear_matching();
 		}
+
+		//Search the subtrees in parallel, every worker has its own search context
+		task_scheduler<partial_task> scheduler(threads);
+		for (size_t task_id = 0; task_id < split_tasks.size(); task_id++) {
+			scheduler.push(std::move(split_tasks[task_id]));
+		}
+		split_tasks.clear();
+		std::vector<matchings> contexts(scheduler.workers());
+		scheduler.run([&contexts](size_t worker_id, const partial_task & task) {
+			contexts[worker_id].search_task(task);
+		});
+#ifndef ORDERLY_GENERATION
 		partial_matchings.clear();
+#endif //ORDERLY_GENERATION
+		results = generated.release();
+	}
+
+	void matchings::search_task(const partial_task & task) {
+		matching = task.matching;
+		hyper_edges = task.hyper_edges;
+		init_candidates(task.count, task.first_empty);
+		find_remaining_edges(task.count, task.first_empty);
 	}
 	
 	void matchings::find_remaining_edges(const sfi count, const sfi first_empty) {
+		// While splitting the search tree, the subtree is only saved to be searched later
+		if (tasks != nullptr && count == GENERATOR_SPLIT_DEPTH) {
+			partial_task task;
+			task.matching = matching;
+			task.hyper_edges = hyper_edges;
+			task.count = count;
+			task.first_empty = first_empty;
+			tasks->push_back(task);
+			return;
+		}
+
 		// Try to add any possible edge  
 		for (sfi end_vertex = first_empty + 1; end_vertex < VERTICES; end_vertex++) {
 			// We need bipartitness
@@ -143,29 +195,30 @@ namespace cube {
 				}
 
 				add_edge(first_empty, end_vertex);
-				// If this is perfect matching, add it into results
-				if (count + 1 == MATCH_SIZE) {
-					add_new_matching();
-				}
-
-				// Otherwise, for up to 10 edges used, we check whether the matching was yet visited (higher number is not effective).
-				else if (count < 10) {
-					perfect_matching min_matching = lex_min_matching();
-					if (partial_matchings.insert(compress_partial(min_matching))) { 
-					//new matching, continue the search
-						sfi new_first_empty = first_empty + 1;
-						while (is_set(new_first_empty))
-							new_first_empty++;
+				sfi new_first_empty = first_empty + 1;
+				while (new_first_empty < VERTICES && is_set(new_first_empty))
+					new_first_empty++;
+
+				// Non-canonical matchings are skipped immediately, their canonical form is searched in other branch
+				if (update_candidates(count, first_empty, end_vertex, new_first_empty)) {
+					// If this is perfect matching, add it into results
+					if (count + 1 == MATCH_SIZE) {
+						add_new_matching();
+					}
+#ifndef ORDERLY_GENERATION
+					// Otherwise, for up to 10 edges used, we mark the matching as visited (higher number is not effective).
+					else if (count < 10) {
+						if (partial_matchings.insert(compress_partial(matching))) {
+							//new matching, continue the search
+							find_remaining_edges(count + 1, new_first_empty);
+						}
+					}
+#endif //ORDERLY_GENERATION
+					// Otherwise, continue without testing.
+					else {
 						find_remaining_edges(count + 1, new_first_empty);
 					}
 				}
-				// Otherwise, continue without testing.
-				else {
-					sfi new_first_empty = first_empty + 1;
-					while (is_set(new_first_empty))
-						new_first_empty++;
-					find_remaining_edges(count + 1, new_first_empty);
-				}
 
 				// Return to initial state.
 				remove_edge(first_empty, end_vertex);
@@ -175,76 +228,25 @@ namespace cube {
 		}
 	}
 
-	sfi matchings::transform(sfi vertex_id) {
-#ifdef _DEBUG
-		//Test of transformation uniqueness
-		if (!transform_data.is_unique())
-			errors::assert_error("Transformation data are not complete!");
-
-		//Test of its validity (the shuffle of coordinates should be a permutation).
-		dimension_states used_dims;
-		FOR_DIMENSION(dim_id) {
-			used_dims[dim_id] = false;
-		}
-		FOR_DIMENSION(dim_id) {
-			if (used_dims[top_one[transform_data.dim_permutation[dim_id]]])
-				errors::assert_error("Transformation data are corrupted!");
-			used_dims[top_one[transform_data.dim_permutation[dim_id]]] = true;
-		}	
-#endif // _DEBUG
-
-		//swapping coordinates
-		vertex_id ^= transform_data.dim_swap;
-
-		//permutating coordinates values
-		sfi transformed_vertex = 0;
-		FOR_DIMENSION(dim_id) {
-			if (vertex_id & (1 << dim_id)) 
-				transformed_vertex ^= (1 << top_one[transform_data.dim_permutation[dim_id]]);
-		}
-		return transformed_vertex;
-	}
-
-	sfi matchings::inverse_transform(sfi vertex_id) {
-#ifdef _DEBUG
-		//Test of transformation uniqueness
-		if (!transform_data.is_unique())
-			errors::assert_error("Transformation data are not complete!");
-
-		//Test of its validity (the shuffle of coordinates should be a permutation).
-		dimension_states used_dims;
-		FOR_DIMENSION(dim_id) {
-			used_dims[dim_id] = false;
-		}
-		FOR_DIMENSION(dim_id) {
-			if (used_dims[top_one[transform_data.dim_permutation[dim_id]]])
-				errors::assert_error("Transformation data are corrupted!");
-			used_dims[top_one[transform_data.dim_permutation[dim_id]]] = true;
-		}
-#endif // _DEBUG
-
-		//permutating coordinates (we need to do inverse the actions in respect to transform())
-		sfi transformed_vertex = 0;
-		FOR_DIMENSION(dim_id) {
-			if (vertex_id & transform_data.dim_permutation[dim_id])
-				transformed_vertex ^= (1 << dim_id);
-		}
-
-		//swapping coordinates values
-		transformed_vertex ^= transform_data.dim_swap;
-
-		return transformed_vertex;
-	}
-
 	void matchings::add_new_matching() {
-		perfect_matching new_match = lex_min_matching();
+#ifdef _DEBUG
+		//The candidates should guarantee that the matching is lexicographically minimal
+		if (lex_min_matching() != matching)
+			errors::assert_error("Generated matching is not canonical!");
+#endif //_DEBUG
 		//try to insert new matching
-		results.insert(compress(new_match));
+#ifdef ORDERLY_GENERATION
+		//Every class of isomorphism is generated exactly once
+		generated.insert_unique(compress(matching));
+#else
+		generated.insert(compress(matching));
+#endif //ORDERLY_GENERATION
 
 #ifdef PROGRESS_INFO
-		cycles++;
-		if (cycles % GENERATED_MATCHINGS_INFO == 0) {
-			std::cout << "Matchings: " << cycles << ", distinct: " << results.size() << std::endl;
+		llfi actual_cycles = ++cycles;
+		if (actual_cycles % GENERATED_MATCHINGS_INFO == 0) {
+			std::lock_guard<std::mutex> lock(output_mutex);
+			std::cout << "Matchings: " << actual_cycles << ", distinct: " << generated.size() << std::endl;
 			std::cout << "Actual: ";
 			FOR_VERTICES(vertex_id) {
 				if (matching[vertex_id] > vertex_id)
@@ -262,6 +264,70 @@ namespace cube {
 #endif // PROGRESS_INFO		
 	}
 
+	bool matchings::init_candidates(const sfi count, const sfi first_empty) {
+		std::vector<candidate> & actual = candidates[count];
+		actual.clear();
+		//The identity (id 0) never changes the matching
+		for (automorphism_id transform_id = 1; transform_id < automorphisms::AUTOMORPHISMS_CNT; transform_id++) {
+			candidate new_candidate;
+			new_candidate.id = transform_id;
+			new_candidate.difference = first_difference(transform_id, 0);
+			if (!keep_candidate(new_candidate, first_empty, actual))
+				return false;
+		}
+		return true;
+	}
+
+	bool matchings::update_candidates(const sfi count, const sfi first_vertex, const sfi second_vertex, const sfi first_empty) {
+		const std::vector<candidate> & previous = candidates[count];
+		std::vector<candidate> & actual = candidates[count + 1];
+		actual.clear();
+		for (size_t candidate_id = 0; candidate_id < previous.size(); candidate_id++) {
+			candidate new_candidate = previous[candidate_id];
+			//Only vertices of the new edge and their images have changed
+			const vertices_array & transform = automorphisms::forward(new_candidate.id);
+			sfi changed = std::min(first_vertex, std::min(transform[first_vertex], transform[second_vertex]));
+			if (changed <= new_candidate.difference) {
+				new_candidate.difference = first_difference(new_candidate.id, changed);
+				if (!keep_candidate(new_candidate, first_empty, actual))
+					return false;
+			}
+			//The difference stays, but the candidate may be worse forever now (see keep_candidate)
+			else if (new_candidate.difference >= first_empty || new_candidate.transformed_neighbour == INVALID) {
+				actual.push_back(new_candidate);
+			}
+		}
+		return true;
+	}
+
+	bool matchings::keep_candidate(candidate & new_candidate, const sfi first_empty, std::vector<candidate> & actual) {
+		if (new_candidate.difference == VERTICES) {
+			//Automorphism of the matching, it may be decided by any of next edges
+			actual.push_back(new_candidate);
+			return true;
+		}
+		new_candidate.transformed_neighbour = transformed(new_candidate.id, new_candidate.difference);
+		if (new_candidate.transformed_neighbour < matching[new_candidate.difference])
+			//The automorphism gives lexicographically smaller matching
+			return false;
+
+		//Vertices before first_empty are already used and never change, thus if the difference is there and the transformed value is set, the automorphism is worse forever
+		if (new_candidate.difference >= first_empty || new_candidate.transformed_neighbour == INVALID)
+			actual.push_back(new_candidate);
+		return true;
+	}
+
+	sfi matchings::first_difference(const automorphism_id transform_id, const sfi start) const {
+		if (simd::available)
+			return simd::first_difference(matching, transform_id);
+
+		for (sfi vertex_id = start; vertex_id < VERTICES; vertex_id++) {
+			if (transformed(transform_id, vertex_id) != matching[vertex_id])
+				return vertex_id;
+		}
+		return VERTICES;
+	}
+
 	void matchings::add_edge(const sfi first_vertex, const sfi second_vertex) {
 #ifdef _DEBUG
 		if (is_set(first_vertex) || is_set(second_vertex))
@@ -300,79 +366,22 @@ namespace cube {
 			sfi second_vertex = matching[vertex_id];
 			//choose every valid edges for the minimal one (both orientations)
 			if (second_vertex != INVALID) {
-				sfi dimension_diff = hamming[vertex_id ^ second_vertex];
 				//best_isomorphic is better while it has better lowest edge
-				if (dimension_diff > hamming[best_isomorphic[0]])
+				if (hamming[vertex_id ^ second_vertex] > hamming[best_isomorphic[0]])
 					continue;
 
-				sfi end_min = 1;
-				while (dimension_diff > 1) {
-					end_min <<= 1;
-					end_min += 1;
-					dimension_diff--;
+				//vertex_id is mapped to 0 and the coordinates in which the edge differs are mapped to the lowest ones - try all such automorphisms
+				const std::vector<automorphism_id> & permutations = automorphisms::low_permutations(vertex_id ^ second_vertex);
+				for (size_t permutation_id = 0; permutation_id < permutations.size(); permutation_id++) {
+					try_transformation(automorphisms::get_id(vertex_id, permutations[permutation_id]));
 				}
-				//get as much information as possible
-				get_transformation(edge(vertex_id, second_vertex), edge(0, end_min));
-				FOR_DIMENSION(dim_id) {
-					used_dimensions[dim_id] = false;
-				}
-				//try all valid permutations
-				generate_possible_transformations(0);
 			}
 		}
 	}
 
-	
-
-
-	void matchings::get_transformation(const edge & base_edge, const edge & transformed_edge) {
-#ifdef _DEBUG
-		if (transformed_edge.first != 0)
-			errors::unimplemented_feature("Transformation is working only for final edge rising from zero!");
-#endif // _DEBUG
-
-		//Get swapping data (it is simple, because we are mapping some vertex to 0th) 
-		transform_data.dim_swap = base_edge.first;
-
-		
-		//Get constrains for possible permutations
-		sfi dist = hamming[base_edge.first ^ base_edge.second];
-		sfi dist_bits = (1 << dist) - 1;
-		FOR_DIMENSION(dim_id) {
-			if ((base_edge.first ^ base_edge.second) & (1 << dim_id)) 
-				//They differ in this coordinate, thus we need to map it into first dist bits (looking for lexicographicaly minimal matching).
-				transform_data.dim_permutation[dim_id] = dist_bits;
-			else 
-				//They dont differ in this coordinate, thus we need to map it into remaining bits
-				transform_data.dim_permutation[dim_id] = DIMENSION_BITS ^ dist_bits;
-		}
-	}
-
-	void matchings::generate_possible_transformations(const sfi count) {
-		if (count == DIMENSION) {
-			//Permutation selected -> try it
-			try_transformation();
-			return;
-		}
-		else {
-			//Save the original data and try all possibilities to fill permutation
-			sfi possibilities = transform_data.dim_permutation[count];
-			FOR_DIMENSION(dim_id) {
-				
-				if (!used_dimensions[dim_id] && possibilities & (1 << dim_id)) {
-					//The choice is possible
-					used_dimensions[dim_id] = true;
-					transform_data.dim_permutation[count] = (1 << dim_id);
-					generate_possible_transformations(count + 1);
-					used_dimensions[dim_id] = false;
-				}
-			}
-			//Restore original value
-			transform_data.dim_permutation[count] = possibilities;
-		}
-	}
-
-	void matchings::try_transformation() {
+	void matchings::try_transformation(const automorphism_id transform_id) {
+		const vertices_array & transform = automorphisms::forward(transform_id);
+		const vertices_array & inverse_transform = automorphisms::inverse(transform_id);
 		FOR_VERTICES(vertex_id) {
 			actual_isomorphic[vertex_id] = INVALID;
 		}
@@ -381,14 +390,14 @@ namespace cube {
 		//Apply the transformation on vertices one-by-one until difference is found between actual_isomorphic and best_isomorphic. Then either break or finish the better isomorphism.
 		FOR_VERTICES(vertex_id) {
 			if (actual_isomorphic[vertex_id] == INVALID) {
-				sfi start_vertex = inverse_transform(vertex_id);
+				sfi start_vertex = inverse_transform[vertex_id];
 				if (!is_set(start_vertex)) { 
 					if (!found_better && best_isomorphic[vertex_id] != INVALID) 
 						//in best_isomorphic this vertex is set, thus actual would be worse
 						return;
 				}
 				else {
-					sfi transformed_neighbour = transform(matching[start_vertex]);
+					sfi transformed_neighbour = transform[matching[start_vertex]];
 					if (!found_better) {
 						//Still not known if the result is better
 						if (transformed_neighbour < best_isomorphic[vertex_id]) {
@@ -412,16 +421,16 @@ namespace cube {
 		}
 	}
 
-	perfect_matching matchings::matching;
 	result_set matchings::results;
-	result_set matchings::partial_matchings;
-	sfi matchings::hyper_edges = 0;
-	dimension_states matchings::used_dimensions;
-	vertices_array matchings::actual_isomorphic;
-	vertices_array matchings::best_isomorphic;
-	transformation matchings::transform_data;
+	concurrent_result_set matchings::generated;
+#ifdef PROGRESS_INFO
+	std::mutex matchings::output_mutex;
+#endif //PROGRESS_INFO
+#ifndef ORDERLY_GENERATION
+	concurrent_result_set matchings::partial_matchings;
+#endif //ORDERLY_GENERATION
 
 #ifdef PROGRESS_INFO	
-	llfi matchings::cycles = 1;
+	std::atomic<llfi> matchings::cycles(1);
 #endif // PROGRESS_INFO	
 }
@@ -4,10 +4,14 @@
 #include "settings.hpp"
 #include "errors.hpp"
 #include "containers.hpp"
-#include "transformation.hpp"
+#include "automorphisms.hpp"
+#include "simd.hpp"
+#include "scheduler.hpp"
 #include <vector>
 #include <array>
 #include <unordered_set>
+#include <mutex>
+#include <atomic>
 
 
 #ifdef __linux__
@@ -22,100 +26,149 @@ namespace cube {
 	/* Decompress given compressed perfect matching back into perfect matching structure. */
 	perfect_matching decompress(llfi compressed_matching);
 
+	/* Returns whether given number is a compressed perfect matching (decompress would set all vertices), it is much cheaper than the decompression itself. */
+	bool is_compressed_matching(llfi compressed_matching);
+
 	/* Compress partial matching with up to 11 edges into llfi.	*/
 	llfi compress_partial(perfect_matching & source_matching);
 
 	/* TODO: Not required, so not implemented */
 	//perfect_matching decompress_partial(llfi comprimed_matching);
 
-	/* Class for generating all possible non-isomorphic matchings and providing functions for transforming matchings with given isomorphism. */
+	/* Class for generating all possible non-isomorphic matchings and providing functions for transforming matchings with given isomorphism.
+	   The generator is parallel - the search tree is split at depth GENERATOR_SPLIT_DEPTH and every subtree is searched by some worker with its own instance (search context) of this class.
+	   With ORDERLY_GENERATION, it is an orderly generator (canonical augmentation): a matching is accepted only if it is lexicographically minimal, 
+	   then its parent (the matching without the last added edge) is minimal as well, thus it was produced exactly once from its canonical parent. */
 	class matchings {
 	public:
-		/* Finds all possible non-isomorphic matchings of chosen dimension and number of edges from hypercube.
+		/* Finds all possible non-isomorphic matchings of chosen dimension and number of edges from hypercube using given number of threads.
 		   Then it saves them into public variable results. */
-		static void find_matchings();
+		static void find_matchings(size_t threads = default_thread_count());
 
 		/* Set of all perfect matchings generated. */
 		static result_set results;
 
+		/* Creates empty search context. */
+		matchings() : hyper_edges(0), tasks(nullptr) {
+			clear_matching();
+		}
+
 	private:
+		/* Automorphism which still may map the partial matching onto lexicographically smaller one. */
+		struct candidate {
+			automorphism_id id;
+			//First vertex in which the transformed matching differs from the matching (VERTICES if they are same)
+			sfi difference;
+			//Neighbour of the difference vertex in the transformed matching
+			sfi transformed_neighbour;
+		};
+
+		/* Partial matching at split depth which is searched independently of others. */
+		struct partial_task {
+			perfect_matching matching;
+			sfi hyper_edges;
+			sfi count;
+			sfi first_empty;
+		};
+
+		//Searches the subtree given by the task
+		void search_task(const partial_task & task);
+
 		//Main recursive function, tries adding edges one-by-one into partial matching while checking, whether that matching has been yet generated and fulfills the restrictions. 
-		static void find_remaining_edges(const sfi count, const sfi first_empty);
+		void find_remaining_edges(const sfi count, const sfi first_empty);
+
+		//Inserts 'matching' (which is lexicographicaly minimal) into results.
+		void add_new_matching();
+
+		//Computes candidates for actual matching with count edges from scratch. Returns false if the matching is not lexicographically minimal.
+		bool init_candidates(const sfi count, const sfi first_empty);
+
+		//Computes candidates for matching with count + 1 edges by filtering candidates for count edges after the given edge was added. Returns false if the matching is not lexicographically minimal.
+		bool update_candidates(const sfi count, const sfi first_vertex, const sfi second_vertex, const sfi first_empty);
+
+		//Adds the candidate with newly computed difference into actual unless it can never give a smaller matching. Returns false if it gives a smaller matching now.
+		bool keep_candidate(candidate & new_candidate, const sfi first_empty, std::vector<candidate> & actual);
+
+		//Returns first vertex (not smaller than start) where the matching transformed by given automorphism differs from matching, all vertices before start must be same.
+		sfi first_difference(const automorphism_id transform_id, const sfi start) const;
 
-		//Gets lexicographicaly minimal matching isomorphic to 'matching' and then inserts it into results.
-		static void add_new_matching();
+		//Returns neighbour of vertex_id in the matching transformed by given automorphism
+		sfi transformed(const automorphism_id transform_id, const sfi vertex_id) const {
+			sfi neighbour = matching[automorphisms::inverse(transform_id)[vertex_id]];
+			return (neighbour == INVALID) ? INVALID : automorphisms::forward(transform_id)[neighbour];
+		}
 
 		//Returns whether the vertex_id is yet in some edge
-		static bool is_set(const sfi vertex_id) {
+		bool is_set(const sfi vertex_id) const {
 			return (matching[vertex_id] != INVALID);
 		}
 
 		//Resets the matching
-		static void clear_matching() {
+		void clear_matching() {
 			FOR_VERTICES(vertex_id) {
 				matching[vertex_id] = INVALID;
 			}
 		}
 
 		//Adds the selected edge into matching
-		static void add_edge(const sfi first_vertex, const sfi second_vertex);
+		void add_edge(const sfi first_vertex, const sfi second_vertex);
 		
 		//Removes the selected edge from matching
-		static void remove_edge(const sfi first_vertex, const sfi second_vertex);
+		void remove_edge(const sfi first_vertex, const sfi second_vertex);
 
 		//Generates lexicographicaly minimal matching to 'matching'. Works for partial matchings as well. 
-		static perfect_matching lex_min_matching();
-
-		//Tries to set all reasonable edges of matching to 0->k and then sets the lexicographicaly minimal as best_isomorphic 
-		static void find_best_transformation();
+		perfect_matching lex_min_matching();
 
-		//Tries all possible permutations of coordinates to be used in an isomorphism
-		static void generate_possible_transformations(const sfi count);
+		//Tries to set all reasonable edges of matching to 0->k by all automorphisms doing so and then sets the lexicographicaly minimal as best_isomorphic 
+		void find_best_transformation();
 		
-		//transforms matching by given transformation and if the result is lexicographicaly smaller than best_isomorphic, it will be replaced
-		static void try_transformation();
-
-		//Transforms vertex_id by transform_data
-		static sfi transform(sfi vertex_id);
-
-		//Returns vertex which will give vertex_id if transformed by transform_data
-		static sfi inverse_transform(sfi vertex_id);
-
-		//Sets transform_data to most-constricted possible after mapping base_edge to transformed_edge (ordering matters).
-		static void get_transformation(const edge & base_edge, const edge & transformed_edge);
+		//transforms matching by given automorphism and if the result is lexicographicaly smaller than best_isomorphic, it will be replaced
+		void try_transformation(const automorphism_id transform_id);
 		
 		//Returns true iff number1 and number2 have the same number of bits set to 1 (they have the same distance to some vertex)
 		static bool is_same_dist(const sfi number1, const sfi number2) {
 			return (hamming[number1] == hamming[number2]);
 		}
 
-		/* Used data structures */
+		/* Shared data structures */
 
 #ifdef PROGRESS_INFO
 		//Number of generated perfect matchings
-		static llfi cycles;
+		static std::atomic<llfi> cycles;
 #endif // PROGRESS_INFO	
 
-		// Perfect matching structure used globaly during the algorithm for storing actual state. 
-		static perfect_matching matching;
+		//Perfect matchings generated by all workers, moved into results at the end
+		static concurrent_result_set generated;
 
+#ifdef PROGRESS_INFO
+		//Guards progress output
+		static std::mutex output_mutex;
+#endif // PROGRESS_INFO
+
+#ifndef ORDERLY_GENERATION
 		//Set of visited states - helps to reduce the branching factor
-		static result_set partial_matchings;
+		static concurrent_result_set partial_matchings;
+#endif //ORDERLY_GENERATION
+
+		/* Data structures of a search context */
+
+		// Perfect matching structure used during the algorithm for storing actual state. 
+		perfect_matching matching;
 
 		// Number of edges in actual partial matching from Q_n 
-		static sfi hyper_edges;
+		sfi hyper_edges;
 
 		//Matching after performing actual transformation
-		static vertices_array actual_isomorphic;
+		vertices_array actual_isomorphic;
 
 		//Lexicographically minimal matching found
-		static vertices_array best_isomorphic; 
+		vertices_array best_isomorphic; 
 
-		//Structure holding (partial) data about transformation, which would be used on current matching.
-		static transformation transform_data;
+		//For every number of edges of the partial matching, the automorphisms which still may show that the matching is not lexicographically minimal (including its stabilizer)
+		std::array<std::vector<candidate>, MATCH_SIZE + 1> candidates;
 
-		//Holds which coordinates were set while creating transform_data
-		static dimension_states used_dimensions;
+		//If set, partial matchings reaching GENERATOR_SPLIT_DEPTH are stored here instead of being searched
+		std::vector<partial_task> * tasks;
 	};
 }
 #endif //MATCHINGS_
\ No newline at end of file
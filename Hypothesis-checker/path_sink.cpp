@@ -0,0 +1,51 @@
+#include "path_sink.hpp"
+#include "serializer.hpp"
+
+namespace cube {
+	size_t path_sink::failures(const std::vector<path> & paths) {
+		size_t failed = 0;
+		for (size_t path_id = 0; path_id < paths.size(); path_id++) {
+			if (!paths[path_id].has_solution)
+				failed++;
+		}
+		return failed;
+	}
+
+	path_file_sink::path_file_sink(const std::string & file_name) {
+		serializer::open_paths(file_name);
+	}
+
+	void path_file_sink::receive(const std::vector<path> & paths) {
+		serializer::save_matching_paths(paths);
+	}
+
+	void path_file_sink::close() {
+		serializer::close_paths();
+	}
+
+	void failure_summary::receive(const std::vector<path> & paths) {
+		size_t failed = failures(paths);
+		//Output only matchings with at least one failed path (for clarity)
+		if (failed > 0) {
+			matchings_cnt++;
+			lines << "Matching ";
+			FOR_VERTICES(vertex_id) {
+				if (paths[0].base_matching[vertex_id] > vertex_id)
+					lines << (size_t)vertex_id << "->" << (size_t)paths[0].base_matching[vertex_id] << ", ";
+			}
+			lines << "impossible: " << failed << std::endl;
+		}
+	}
+
+	void failure_summary::print(std::ostream & output) const {
+		output << "Matchings with impossible configurations:" << std::endl;
+		output << lines.str();
+		output << "Total number of matchings with unsolved configurations: " << matchings_cnt << std::endl;
+	}
+
+	void sink_group::receive(const std::vector<path> & paths) {
+		for (size_t sink_id = 0; sink_id < sinks.size(); sink_id++) {
+			sinks[sink_id]->receive(paths);
+		}
+	}
+}
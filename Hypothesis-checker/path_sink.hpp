@@ -0,0 +1,72 @@
+#ifndef PATH_SINK_
+#define PATH_SINK_
+
+#include "settings.hpp"
+#include "path.hpp"
+#include "errors.hpp"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <ostream>
+
+namespace cube {
+	/* Receiver of the results of pathfinding. The paths of all pairs of ending vertices of a matching with a failure are passed at once in the order of sequential iteration
+	   as soon as all previous matchings are solved, thus the memory of the pathfinding does not depend on the number of matchings. */
+	class path_sink {
+	public:
+		virtual ~path_sink() {}
+
+		/* Receives the paths of all pairs of ending vertices of a matching. */
+		virtual void receive(const std::vector<path> & paths) = 0;
+
+		/* Returns the number of pairs without a path. */
+		static size_t failures(const std::vector<path> & paths);
+	};
+
+	/* Sink writing the received paths into a file by the serializer. */
+	class path_file_sink : public path_sink {
+	public:
+		/* Opens the file. */
+		explicit path_file_sink(const std::string & file_name);
+
+		void receive(const std::vector<path> & paths) override;
+
+		/* Closes the file (it has to be called after the pathfinding). */
+		void close();
+	};
+
+	/* Sink summarizing the matchings with a failure - their edges and the number of pairs without a path. */
+	class failure_summary : public path_sink {
+	public:
+		failure_summary() : matchings_cnt(0) {}
+
+		void receive(const std::vector<path> & paths) override;
+
+		/* Writes the summary. */
+		void print(std::ostream & output) const;
+
+	private:
+		//Lines of the matchings with a failure
+		std::ostringstream lines;
+
+		//Number of matchings with a failure
+		size_t matchings_cnt;
+	};
+
+	/* Sink passing the results to all added sinks. */
+	class sink_group : public path_sink {
+	public:
+		/* Adds the sink, it has to exist until the group is used. */
+		void add(path_sink & sink) {
+			sinks.push_back(&sink);
+		}
+
+		void receive(const std::vector<path> & paths) override;
+
+	private:
+		//Added sinks
+		std::vector<path_sink *> sinks;
+	};
+}
+
+#endif //PATH_SINK_
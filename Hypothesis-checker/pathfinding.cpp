@@ -1,103 +1,257 @@
 #include "pathfinding.hpp"
 
 namespace cube {
-	std::vector<path> pathfinding::find_paths(const result_set & matchings) {
-		std::vector<path> results;
+	void pathfinding::find_paths(const result_set & matchings, path_sink & sink, size_t threads, solver_type solver, const std::string & cost_log_file) {
+		llfi counterexamples = solve_all(matchings, sink, threads, solver, cost_log_file);
 
-#ifdef PROGRESS_INFO
-		llfi matchings_solved = 0; 
-#endif //PROGRESS_INFO
+		// Analysing the result
+		if (counterexamples == 0) {
+			std::cout << "No counterexample was found!" << std::endl;
+		}
+		else {
+			std::cout << "There were " << counterexamples << " counterexamples found, the hypothesis is wrong for dimension " << (size_t)DIMENSION << std::endl;
+		}
+	}
 
-		for (llfi block_id = 0; block_id < PRIME_MOD; block_id++) {
-			for (auto it = matchings[block_id].begin(); it != matchings[block_id].end(); it++) {
-				perfect_matching act_matching = decompress(*it);
-				check_one_dimension(act_matching);
-				bad_num = 0;
-				FOR_VERTICES(start_vertex) {
-					for (sfi end_vertex = start_vertex + 1; end_vertex < VERTICES; end_vertex++) {
-						//If start_vertex and end_vertex are in opposite partities and not connected, try to find a path
-						if (((hamming[start_vertex] - hamming[end_vertex]) & 1) == 1 && act_matching[start_vertex] != end_vertex) {
-							actual_path = path(act_matching, start_vertex, end_vertex);
-							solve();
-							//Check hypothesis for the failure
-							if (!actual_path.has_solution) {
-								check_hypothesis(actual_path);
-							}
-							results.push_back(std::move(actual_path));
-						}
-					}
+	llfi pathfinding::solve_all(const result_set & matchings, path_sink & sink, size_t threads, solver_type solver, const std::string & cost_log_file) {
+		std::ofstream cost_log;
+		if (!cost_log_file.empty()) {
+			cost_log.open(cost_log_file, std::ios::out);
+			if (cost_log.fail())
+				errors::output_error("An error occured when opening " + cost_log_file);
+			cost_model::write_log_header(cost_log);
+		}
+
+		//Every worker has its own solver context, the costs are estimated in parallel too
+		std::vector<pathfinding> contexts((threads == 0) ? 1 : threads);
+		task_scheduler<solver_task> scheduler(threads);
+		for (size_t worker_id = 0; worker_id < contexts.size(); worker_id++) {
+			contexts[worker_id].solver = solver;
+			contexts[worker_id].scheduler = &scheduler;
+			contexts[worker_id].worker_id = worker_id;
+		}
+
+		//The matchings are loaded from the blocks of the container, estimated and solved by windows, thus only the window in flight is held with its stabilizers
+		std::vector<scheduled_matching> schedule;
+		schedule.reserve(std::min<llfi>(matchings.size(), PATHFINDING_SCHEDULE_WINDOW));
+		llfi block_id = 0;
+		result_block::iterator block_it = matchings[block_id].begin();
+		llfi window_begin = 0;
+		llfi counterexamples = 0;
+		std::mutex output_mutex;
+		while (true) {
+			//Number the next window of matchings in the order of sequential iteration
+			schedule.clear();
+			while (schedule.size() < PATHFINDING_SCHEDULE_WINDOW && block_id < matchings.block_count()) {
+				if (block_it == matchings[block_id].end()) {
+					if (++block_id < matchings.block_count())
+						block_it = matchings[block_id].begin();
+					continue;
+				}
+				scheduled_matching scheduled;
+				scheduled.index = window_begin + schedule.size();
+				scheduled.compressed = *block_it++;
+				scheduled.cost = 0;
+				schedule.push_back(scheduled);
+			}
+			if (schedule.empty())
+				break;
+
+			for (llfi begin = 0; begin < schedule.size(); begin += PATHFINDING_TASK_MATCHINGS) {
+				solver_task task = solver_task();
+				task.begin = begin;
+				task.end = std::min<llfi>(begin + PATHFINDING_TASK_MATCHINGS, schedule.size());
+				scheduler.push(std::move(task));
+			}
+			scheduler.run([&](size_t worker_id, const solver_task & task) {
+				contexts[worker_id].estimate_task(schedule, task.begin, task.end);
+			});
+
+			//The most expensive matchings go first (ties in the order of sequential iteration) and they are grouped into tasks of limited estimated cost
+			std::sort(schedule.begin(), schedule.end(), [](const scheduled_matching & first, const scheduled_matching & second) {
+				return first.cost > second.cost || (first.cost == second.cost && first.index < second.index);
+			});
+			double window_cost = 0;
+			for (llfi scheduled_id = 0; scheduled_id < schedule.size(); scheduled_id++) {
+				window_cost += schedule[scheduled_id].cost;
+			}
+			double task_budget = window_cost / (scheduler.workers() * PATHFINDING_TASKS_PER_WORKER);
+			std::vector<solver_task> tasks;
+			for (llfi begin = 0; begin < schedule.size();) {
+				solver_task task = solver_task();
+				task.begin = begin;
+				task.end = begin + 1;
+				double task_cost = schedule[begin].cost;
+				while (task.end < schedule.size() && task.end - task.begin < PATHFINDING_TASK_MATCHINGS && task_cost + schedule[task.end].cost <= task_budget) {
+					task_cost += schedule[task.end].cost;
+					task.end++;
+				}
+				begin = task.end;
+				tasks.push_back(std::move(task));
+			}
+			//The workers take the tasks from the back of their queues, thus the cheapest tasks are pushed first (and stolen first by idle workers)
+			for (size_t task_id = tasks.size(); task_id > 0; task_id--) {
+				scheduler.push(std::move(tasks[task_id - 1]));
+			}
+
+			//Outputs of matchings are written in the order of sequential iteration as soon as all previous matchings of the window are solved
+			std::vector<bool> finished(schedule.size(), false);
+			std::map<llfi, matching_output> pending;
+			llfi next_output = window_begin;
+			scheduler.run([&](size_t worker_id, const solver_task & task) {
+				if (task.split) {
+					contexts[worker_id].help(*task.split);
+					return;
 				}
-				number_check();
+				task_output output;
+				contexts[worker_id].solve_task(schedule, task.begin, task.end, cost_log.is_open(), output);
 
+				std::lock_guard<std::mutex> lock(output_mutex);
+				counterexamples += output.counterexamples;
+				for (size_t output_id = 0; output_id < output.matchings.size(); output_id++) {
+					pending[output.matchings[output_id].index] = std::move(output.matchings[output_id]);
+				}
+				for (llfi scheduled_id = task.begin; scheduled_id < task.end; scheduled_id++) {
+					finished[schedule[scheduled_id].index - window_begin] = true;
+				}
+				while (next_output - window_begin < finished.size() && finished[next_output - window_begin]) {
+					auto it = pending.find(next_output);
+					if (it != pending.end()) {
+						std::cout << it->second.report;
+						if (cost_log.is_open())
+							cost_log << it->second.log;
+						if (!it->second.paths.empty())
+							sink.receive(it->second.paths);
+						pending.erase(it);
+					}
+					next_output++;
 #ifdef PROGRESS_INFO
-				matchings_solved++; 
-				if (matchings_solved % GENERATED_PATHS_INFO == 0)
-					std::cout << matchings_solved << " matchings solved" << std::endl;
+					if (next_output % GENERATED_PATHS_INFO == 0)
+						std::cout << next_output << " matchings solved" << std::endl;
 #endif //PROGRESS_INFO
+				}
+				std::cout.flush();
+			});
+			window_begin += schedule.size();
+		}
+
+#ifdef SOLUTION_POOL
+		pool_statistics total_stats;
+		for (size_t worker_id = 0; worker_id < contexts.size(); worker_id++) {
+			total_stats.direct_hits += contexts[worker_id].pool_stats.direct_hits;
+			total_stats.exchange_hits += contexts[worker_id].pool_stats.exchange_hits;
+			total_stats.misses += contexts[worker_id].pool_stats.misses;
+		}
+		std::cout << "Solution pool: " << total_stats.direct_hits << " direct hits, " << total_stats.exchange_hits << " exchange hits, " << total_stats.misses << " misses" << std::endl;
+#endif //SOLUTION_POOL
+		if (subcube_table::is_loaded()) {
+			llfi split_hits = 0;
+			llfi split_misses = 0;
+			for (size_t worker_id = 0; worker_id < contexts.size(); worker_id++) {
+				split_hits += contexts[worker_id].split_hits;
+				split_misses += contexts[worker_id].split_misses;
 			}
+			std::cout << "Split: " << split_hits << " pairs constructed, " << split_misses << " pairs searched" << std::endl;
 		}
 
-		// Analysing the result
-		if (counterexamples == 0) {
-			std::cout << "No counterexample was found!"  << std::endl;
-		}
-		else {
-			std::cout << "There were " << counterexamples << " counterexamples found, the hypothesis is wrong for dimension " << DIMENSION << std::endl;
-		}
+		if (cost_log.is_open() && cost_log.fail())
+			errors::output_error("An error occured while writing the calibration log!");
+		return counterexamples;
+	}
 
-		return std::move(results);
+	void pathfinding::estimate_task(std::vector<scheduled_matching> & schedule, llfi begin, llfi end) {
+		for (llfi scheduled_id = begin; scheduled_id < end; scheduled_id++) {
+			perfect_matching act_matching = decompress(schedule[scheduled_id].compressed);
+			check_one_dimension(act_matching);
+			find_stabilizer(act_matching);
+			schedule[scheduled_id].cost = cost_model::estimate(cost_model::extract(act_matching, all_parallel, stabilizer.size()));
+			if (stabilizer.size() > 1)
+				schedule[scheduled_id].stabilizer = stabilizer;
+		}
 	}
 
-	std::vector<path> pathfinding::find_unsolved_paths(const result_set & matchings) {
-		std::vector<path> results;
-#ifdef PROGRESS_INFO
-		int matchings_solved = 0;
-#endif //PROGRESS_INFO
-		for (llfi block_id = 0; block_id < PRIME_MOD; block_id++) {
-			for (auto it = matchings[block_id].begin(); it != matchings[block_id].end(); it++) {
-				perfect_matching act_matching = decompress(*it);
-				bool OK = true;
-				check_one_dimension(act_matching);
-				bad_num = 0;
-				for (sfi start_vertex = 0; start_vertex < VERTICES; start_vertex++) {
-					for (sfi end_vertex = start_vertex + 1; end_vertex < VERTICES; end_vertex++) {
-						//If start_vertex and end_vertex are in opposite partities and not connected, try to find a path
-						if (((hamming[start_vertex] - hamming[end_vertex]) & 1) == 1 && act_matching[start_vertex] != end_vertex) {
-							actual_path = path(act_matching, start_vertex, end_vertex);
-							solve();
-							//Check hypothesis for the failure
-							if (!actual_path.has_solution) {
-								OK = false;
-								check_hypothesis(actual_path);
+	void pathfinding::solve_task(const std::vector<scheduled_matching> & schedule, llfi begin, llfi end, bool log_costs, task_output & output) {
+		counterexamples = 0;
+		for (llfi scheduled_id = begin; scheduled_id < end; scheduled_id++) {
+			perfect_matching act_matching = decompress(schedule[scheduled_id].compressed);
+			matching_output matching_result;
+			matching_result.index = schedule[scheduled_id].index;
+			report.str("");
+			bool OK = true;
+			check_one_dimension(act_matching);
+			prepare_matching(act_matching);
+			bad_num = 0;
+			llfi first_node = nodes + bitboard.nodes();
+			//Results of the pairs split among workers (if the matching is a straggler) and the number of nodes searched before the split
+			std::shared_ptr<straggler> split;
+			size_t split_id = 0;
+			llfi split_node = 0;
+			//The stabilizer was already found by the estimation
+			if (schedule[scheduled_id].stabilizer.empty())
+				stabilizer.assign(1, 0);
+			else
+				stabilizer = schedule[scheduled_id].stabilizer;
+			FOR_VERTICES(start_vertex) {
+				for (sfi end_vertex = start_vertex + 1; end_vertex < VERTICES; end_vertex++) {
+					//If start_vertex and end_vertex are in opposite partities and not connected, try to find a path
+					if (((hamming[start_vertex] - hamming[end_vertex]) & 1) == 1 && act_matching[start_vertex] != end_vertex) {
+						actual_path = path(act_matching, start_vertex, end_vertex);
+#ifdef SYMMETRY_REDUCTION
+						if (split) {
+							edge smallest_pair;
+							automorphism_id transform_id = find_representative(start_vertex, end_vertex, smallest_pair);
+							path & representative = representatives[smallest_pair.first * VERTICES + smallest_pair.second];
+							if (transform_id == 0) {
+								actual_path = std::move(split->results[split_id++]);
+								representative = actual_path;
 							}
-							results.push_back(std::move(actual_path));
+							else
+								map_representative(transform_id, representative);
+						}
+						else
+							solve_symmetric();
+#else
+						if (split)
+							actual_path = std::move(split->results[split_id++]);
+						else
+							solve();
+#endif //SYMMETRY_REDUCTION
+						//Check hypothesis for the failure
+						if (!actual_path.has_solution) {
+							OK = false;
+							check_hypothesis(actual_path);
+						}
+						matching_result.paths.push_back(std::move(actual_path));
+						//The matching is a straggler, split its remaining pairs if there are other workers
+						if (!split && nodes + bitboard.nodes() - first_node > STRAGGLER_NODES && scheduler->workers() > 1) {
+							split_node = nodes + bitboard.nodes();
+							split = split_matching(act_matching, start_vertex, end_vertex);
 						}
 					}
 				}
-				number_check();
-				//If none failure was found, remove this matching from result
-				if (OK) {
-					for (int i = 0; i < BIPARTITE_PAIRS_CNT; i++) {
-						results.pop_back();
-					}
-				}
-#ifdef PROGRESS_INFO
-				matchings_solved++;
-				if (matchings_solved % GENERATED_PATHS_INFO == 0)
-					std::cout << matchings_solved << " matchings solved" << std::endl;
-#endif //PROGRESS_INFO
 			}
+			number_check();
+			//If none failure was found, remove this matching from result
+			if (OK)
+				std::vector<path>().swap(matching_result.paths);
+			matching_result.report = report.str();
+			if (log_costs) {
+				llfi matching_nodes = split ? split_node - first_node + split->nodes : nodes + bitboard.nodes() - first_node;
+				std::ostringstream log_line;
+				cost_model::write_log_line(log_line, matching_result.index, schedule[scheduled_id].compressed, cost_model::extract(act_matching, all_parallel, stabilizer.size()), matching_nodes);
+				matching_result.log = log_line.str();
+			}
+			if (!matching_result.report.empty() || !matching_result.log.empty() || !matching_result.paths.empty())
+				output.matchings.push_back(std::move(matching_result));
 		}
+		output.counterexamples = counterexamples;
+	}
 
-		// Analysing the result
-		if (counterexamples == 0) {
-			std::cout << "No counterexample was found!" << std::endl;
-		}
-		else {
-			std::cout << "There were " << counterexamples << " counterexamples found, the hypothesis is wrong for dimension " << (size_t)DIMENSION << std::endl;
-		}
-
-		return std::move(results);
+	bool pathfinding::has_path(const perfect_matching & matching, sfi start_vertex, sfi end_vertex, perfect_matching & found_path) {
+		actual_path = path(matching, start_vertex, end_vertex);
+		solve();
+		found_path = actual_path.found_path;
+		return actual_path.has_solution;
 	}
 
 	void pathfinding::check_one_dimension(const perfect_matching & matching) {
@@ -114,22 +268,22 @@ namespace cube {
 		if (bad_num > 0 && DIMENSION > 3) {
 			if (all_parallel) {
 				if (bad_num == TYPE1_CNT || bad_num == (TYPE1_CNT >> 1)) {
-					std::cout << "Number OK (type 1): " << bad_num << std::endl;
+					report << "Number OK (type 1): " << bad_num << std::endl;
 				}
 				else
-					std::cout << "Matching type 1 warning: Unexpected number " << bad_num << std::endl;
+					report << "Matching type 1 warning: Unexpected number " << bad_num << std::endl;
 			}
 			else {
 				if (bad_num == 1 || bad_num == 2) {
-					std::cout << "Number OK (type 2): " << bad_num << std::endl;
+					report << "Number OK (type 2): " << bad_num << std::endl;
 				}
 				else
-					std::cout << "Matching type 2 warning: Unexpected number " << bad_num << std::endl;
+					report << "Matching type 2 warning: Unexpected number " << bad_num << std::endl;
 			}
 		}
 		//for dimension 3, numbers of failures are not regular, therefore we will not test it
 		else if (bad_num > 0) {
-			std::cout << "Number OK: " << bad_num << std::endl;
+			report << "Number OK: " << bad_num << std::endl;
 		}
 	}
 	void pathfinding::check_hypothesis(path & this_path) {
@@ -199,16 +353,308 @@ namespace cube {
 		this_path.base_matching[end_neighbour] = end_vertex;
 
 		if (fail) {
-			std::cout << "Matching failed: Not a half-layer " << (size_t)start_vertex << ", " << (size_t)end_vertex << std::endl;
+			report << "Matching failed: Not a half-layer " << (size_t)start_vertex << ", " << (size_t)end_vertex << std::endl;
 			counterexamples++;
 		}
 	}
 
+	void pathfinding::find_stabilizer(const perfect_matching & matching) {
+		stabilizer.clear();
+		for (automorphism_id transform_id = 0; transform_id < automorphisms::AUTOMORPHISMS_CNT; transform_id++) {
+			//The automorphism g maps the matching onto itself iff g(matching[v]) = matching[g(v)] for every vertex v (most automorphisms fail at first vertices)
+			const vertices_array & transform = automorphisms::forward(transform_id);
+			bool is_fixed = true;
+			FOR_VERTICES(vertex_id) {
+				if (transform[matching[vertex_id]] != matching[transform[vertex_id]]) {
+					is_fixed = false;
+					break;
+				}
+			}
+			if (is_fixed)
+				stabilizer.push_back(transform_id);
+		}
+	}
+
+	std::shared_ptr<pathfinding::straggler> pathfinding::split_matching(const perfect_matching & matching, sfi start_vertex, sfi end_vertex) {
+		std::shared_ptr<straggler> split = std::make_shared<straggler>();
+		split->matching = matching;
+		//Collect the pairs following the given one in the order of solving
+		for (sfi first_vertex = start_vertex; first_vertex < VERTICES; first_vertex++) {
+			for (sfi second_vertex = (first_vertex == start_vertex) ? end_vertex + 1 : first_vertex + 1; second_vertex < VERTICES; second_vertex++) {
+				if (((hamming[first_vertex] - hamming[second_vertex]) & 1) == 1 && matching[first_vertex] != second_vertex) {
+#ifdef SYMMETRY_REDUCTION
+					//Only the representatives are solved, the other pairs are mapped from them
+					edge smallest_pair;
+					if (find_representative(first_vertex, second_vertex, smallest_pair) != 0)
+						continue;
+#endif //SYMMETRY_REDUCTION
+					split->pairs.push_back(edge(first_vertex, second_vertex));
+				}
+			}
+		}
+		split->results.resize(split->pairs.size());
+		split->chunks_cnt = (split->pairs.size() + STRAGGLER_CHUNK_PAIRS - 1) / STRAGGLER_CHUNK_PAIRS;
+
+		//Other workers steal the requests for help from the front of the queue, every request is worth a single chunk at most
+		for (size_t request_id = 1; request_id < split->chunks_cnt && request_id < scheduler->workers(); request_id++) {
+			solver_task request = solver_task();
+			request.split = split;
+			scheduler->push_front(worker_id, std::move(request));
+		}
+		solve_chunks(*split);
+		//Wait for the chunks taken by other workers
+		std::unique_lock<std::mutex> lock(split->lock);
+		split->finished.wait(lock, [&split]() { return split->done_chunks == split->chunks_cnt; });
+		return split;
+	}
+
+	void pathfinding::help(straggler & split) {
+		//Nothing is left for this worker
+		if (split.next_chunk >= split.chunks_cnt)
+			return;
+		prepare_matching(split.matching);
+		solve_chunks(split);
+	}
+
+	void pathfinding::solve_chunks(straggler & split) {
+		llfi first_node = nodes + bitboard.nodes();
+		size_t chunk_id;
+		while ((chunk_id = split.next_chunk++) < split.chunks_cnt) {
+			size_t chunk_end = std::min((chunk_id + 1) * STRAGGLER_CHUNK_PAIRS, split.pairs.size());
+			for (size_t pair_id = chunk_id * STRAGGLER_CHUNK_PAIRS; pair_id < chunk_end; pair_id++) {
+				actual_path = path(split.matching, split.pairs[pair_id].first, split.pairs[pair_id].second);
+				solve();
+				split.results[pair_id] = std::move(actual_path);
+			}
+			split.nodes += nodes + bitboard.nodes() - first_node;
+			first_node = nodes + bitboard.nodes();
+			if (++split.done_chunks == split.chunks_cnt) {
+				//The owner checks the count under the lock, thus the signal cannot be lost
+				std::lock_guard<std::mutex> lock(split.lock);
+				split.finished.notify_all();
+			}
+		}
+	}
+
+	automorphism_id pathfinding::find_representative(sfi start_vertex, sfi end_vertex, edge & smallest_pair) const {
+		//Find the smallest pair of the orbit (pairs are ordered as in the loops over endpoints, so it was already visited) and the automorphism mapping actual pair onto it
+		automorphism_id best_id = 0;
+		sfi best_start = start_vertex;
+		sfi best_end = end_vertex;
+		//The first automorphism is the identity
+		for (size_t stabilizer_id = 1; stabilizer_id < stabilizer.size(); stabilizer_id++) {
+			const vertices_array & transform = automorphisms::forward(stabilizer[stabilizer_id]);
+			sfi first_vertex = std::min(transform[start_vertex], transform[end_vertex]);
+			sfi second_vertex = std::max(transform[start_vertex], transform[end_vertex]);
+			if (first_vertex < best_start || (first_vertex == best_start && second_vertex < best_end)) {
+				best_id = stabilizer[stabilizer_id];
+				best_start = first_vertex;
+				best_end = second_vertex;
+			}
+		}
+		smallest_pair = edge(best_start, best_end);
+		return best_id;
+	}
+
+	void pathfinding::map_representative(automorphism_id transform_id, const path & representative) {
+		actual_path.has_solution = representative.has_solution;
+		if (actual_path.has_solution) {
+			const vertices_array & transform = automorphisms::forward(transform_id);
+			const vertices_array & inverse = automorphisms::inverse(transform_id);
+			FOR_VERTICES(vertex_id) {
+				actual_path.found_path[vertex_id] = inverse[representative.found_path[transform[vertex_id]]];
+			}
+		}
+#ifdef _DEBUG
+		check_solution();
+#endif //_DEBUG
+	}
+
+	void pathfinding::solve_symmetric() {
+		edge smallest_pair;
+		automorphism_id transform_id = find_representative(actual_path.start_vertex, actual_path.end_vertex, smallest_pair);
+		path & representative = representatives[smallest_pair.first * VERTICES + smallest_pair.second];
+		//This pair is the representative of its orbit, solve it
+		if (transform_id == 0) {
+			solve();
+			representative = actual_path;
+			return;
+		}
+
+		//Otherwise map the solution of the representative back by the inverse automorphism
+		map_representative(transform_id, representative);
+	}
+
 	void pathfinding::solve() {
-		prepare_data();
-		choose_next(0);
+		//The construction from the table of subcubes costs only a few lookups, thus it goes first
+		if (split_dims != 0) {
+			if (solve_split()) {
+				split_hits++;
+#ifdef SOLUTION_POOL
+				pool_solution();
+#endif //SOLUTION_POOL
+#ifdef _DEBUG
+				check_solution();
+#endif //_DEBUG
+				return;
+			}
+			split_misses++;
+		}
+#ifdef SOLUTION_POOL
+		if (reuse_solution()) {
+#ifdef _DEBUG
+			check_solution();
+#endif //_DEBUG
+			return;
+		}
+#endif //SOLUTION_POOL
+		if (solver == solver_type::BITBOARD)
+			bitboard.solve(actual_path);
+		else {
+			prepare_data();
+			choose_next(0);
+		}
+#ifdef SOLUTION_POOL
+		if (actual_path.has_solution)
+			pool_solution();
+#endif //SOLUTION_POOL
+
+#ifdef _DEBUG
+		check_solution();
+#endif //_DEBUG
+	}
+
+#ifdef SOLUTION_POOL
+	bool pathfinding::reuse_solution() {
+		sfi start_vertex = actual_path.start_vertex;
+		sfi end_vertex = actual_path.end_vertex;
+		for (sfi pool_id = 0; pool_id < pool_size; pool_id++) {
+			const pooled_solution & solution = pool[pool_id];
+			//The cycle contains the edge start_vertex->end_vertex, the path is obtained by removing it
+			if (hamming[solution.ends.first ^ solution.ends.second] == 1 && solution.found_path[start_vertex] == end_vertex) {
+				actual_path.found_path = solution.found_path;
+				actual_path.has_solution = true;
+				pool_stats.direct_hits++;
+				return true;
+			}
+
+			//Select the common ending vertex (kept), the old ending vertex which is moved and the new one (target)
+			sfi kept_vertex, moved_vertex, target_vertex;
+			if (start_vertex == solution.ends.first || start_vertex == solution.ends.second) {
+				kept_vertex = start_vertex;
+				target_vertex = end_vertex;
+			}
+			else if (end_vertex == solution.ends.first || end_vertex == solution.ends.second) {
+				kept_vertex = end_vertex;
+				target_vertex = start_vertex;
+			}
+			else
+				continue;
+			moved_vertex = (solution.ends.first == kept_vertex) ? solution.ends.second : solution.ends.first;
+			sfi neighbour = solution.found_path[target_vertex];
+			actual_path.found_path = solution.found_path;
+			actual_path.found_path[kept_vertex] = target_vertex;
+			actual_path.found_path[target_vertex] = kept_vertex;
+			//A rotation (connecting moved_vertex and neighbour directly) would always split the cycle because of parity, thus one more edge of the path is exchanged -
+			//moved_vertex and neighbour are connected to the ends of another edge of the path
+			FOR_VERTICES(vertex_id) {
+				if (solution.found_path[vertex_id] < vertex_id || vertex_id == target_vertex || vertex_id == neighbour || vertex_id == kept_vertex || vertex_id == moved_vertex)
+					continue;
+				sfi first_vertex = vertex_id;
+				sfi second_vertex = solution.found_path[vertex_id];
+				for (sfi orientation = 0; orientation < 2; orientation++) {
+					if (hamming[moved_vertex ^ first_vertex] == 1 && hamming[neighbour ^ second_vertex] == 1) {
+						actual_path.found_path[moved_vertex] = first_vertex;
+						actual_path.found_path[first_vertex] = moved_vertex;
+						actual_path.found_path[neighbour] = second_vertex;
+						actual_path.found_path[second_vertex] = neighbour;
+						if (is_hamiltonian_cycle()) {
+							actual_path.has_solution = true;
+							pool_stats.exchange_hits++;
+							return true;
+						}
+						actual_path.found_path[first_vertex] = second_vertex;
+						actual_path.found_path[second_vertex] = first_vertex;
+					}
+					std::swap(first_vertex, second_vertex);
+				}
+			}
+		}
+		pool_stats.misses++;
+		return false;
+	}
+
+	void pathfinding::pool_solution() {
+		pooled_solution & solution = pool[pool_next];
+		solution.ends = edge(actual_path.start_vertex, actual_path.end_vertex);
+		solution.found_path = actual_path.found_path;
+		pool_next = (pool_next + 1) % SOLUTION_POOL_SIZE;
+		if (pool_size < SOLUTION_POOL_SIZE)
+			pool_size++;
+	}
+
+	bool pathfinding::is_hamiltonian_cycle() const {
+		sfi length = 0;
+		sfi actual_vertex = 0;
+		do {
+			actual_vertex = actual_path.found_path[actual_path.base_matching[actual_vertex]];
+			length += 2;
+		} while (actual_vertex != 0);
+		return length == VERTICES;
+	}
+#endif //SOLUTION_POOL
+
+	bool pathfinding::solve_split() {
+		sfi start_vertex = actual_path.start_vertex;
+		sfi end_vertex = actual_path.end_vertex;
+		for (sfi dim = 0; dim < DIMENSION; dim++) {
+			sfi dim_bit = 1 << dim;
+			//The ending vertices have to lie in different halves
+			if (!(split_dims & dim_bit) || !((start_vertex ^ end_vertex) & dim_bit))
+				continue;
+			llfi start_rank = half_rank[dim][(start_vertex >> dim) & 1];
+			llfi end_rank = half_rank[dim][(end_vertex >> dim) & 1];
+			//The path leaves the half of start_vertex from a vertex of opposite parity, its neighbour in the other half has the parity of start_vertex (opposite to end_vertex)
+			FOR_VERTICES(crossing_vertex) {
+				if (((crossing_vertex ^ start_vertex) & dim_bit) || !((hamming[crossing_vertex] ^ hamming[start_vertex]) & 1))
+					continue;
+				subcube_table::path_code start_code = subcube_table::find_path(start_rank, subcube_table::half_index(start_vertex, dim), subcube_table::half_index(crossing_vertex, dim));
+				if (start_code == subcube_table::NO_PATH)
+					continue;
+				subcube_table::path_code end_code = subcube_table::find_path(end_rank, subcube_table::half_index(crossing_vertex ^ dim_bit, dim), subcube_table::half_index(end_vertex, dim));
+				if (end_code == subcube_table::NO_PATH)
+					continue;
+				//Glue the paths of both halves by the edge between crossing_vertex and its neighbour
+				actual_path.found_path.fill(INVALID);
+				add_half_path(dim, start_code, start_vertex, crossing_vertex);
+				add_half_path(dim, end_code, crossing_vertex ^ dim_bit, end_vertex);
+				actual_path.found_path[crossing_vertex] = crossing_vertex ^ dim_bit;
+				actual_path.found_path[crossing_vertex ^ dim_bit] = crossing_vertex;
+				actual_path.found_path[start_vertex] = end_vertex;
+				actual_path.found_path[end_vertex] = start_vertex;
+				actual_path.has_solution = true;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void pathfinding::add_half_path(sfi dim, subcube_table::path_code code, sfi first_vertex, sfi second_vertex) {
+		//The code starts at the ending vertex which is even in the half
+		sfi actual_vertex = (hamming[subcube_table::half_index(first_vertex, dim)] & 1) ? second_vertex : first_vertex;
+		for (sfi step_id = 0; step_id < (MATCH_SIZE >> 1) - 1; step_id++) {
+			actual_vertex = actual_path.base_matching[actual_vertex];
+			//The dimensions of the half above the split one are shifted by one
+			sfi half_dim = subcube_table::step_dimension(code, step_id);
+			sfi next_vertex = actual_vertex ^ (1 << ((half_dim < dim) ? half_dim : half_dim + 1));
+			actual_path.found_path[actual_vertex] = next_vertex;
+			actual_path.found_path[next_vertex] = actual_vertex;
+			actual_vertex = next_vertex;
+		}
+	}
 
-#ifdef _DEBUG 
+#ifdef _DEBUG
+	void pathfinding::check_solution() {
 		//Check that the result is really a path. 
 		if (actual_path.has_solution) {
 			if (actual_path.found_path[actual_path.start_vertex] != actual_path.end_vertex || actual_path.found_path[actual_path.end_vertex] != actual_path.start_vertex)
@@ -231,83 +677,98 @@ namespace cube {
 			if (actual_path.base_matching[act_vertex] != actual_path.end_vertex)
 				errors::assert_error("The \"path\" has a cycle!");
 		}
-#endif // _DEBUG
 	}
+#endif // _DEBUG
 
-	void pathfinding::prepare_data() {
-
-		sfi component_id = 0;
-		//prepare vertex_component:
+	void pathfinding::prepare_matching(const perfect_matching & matching) {
+		pool_size = 0;
+		pool_next = 0;
+		if (solver == solver_type::BITBOARD)
+			bitboard.prepare(matching);
+		//find dimensions splitting the matching into matchings of both halves
+		split_dims = 0;
+		if (subcube_table::is_loaded()) {
+			sfi crossed = 0;
+			FOR_VERTICES(vertex_id) {
+				crossed |= vertex_id ^ matching[vertex_id];
+			}
+			for (sfi dim = 0; dim < DIMENSION; dim++) {
+				if (crossed & (1 << dim))
+					continue;
+				split_dims |= 1 << dim;
+				std::array<std::array<sfi, MATCH_SIZE>, 2> halves;
+				FOR_VERTICES(vertex_id) {
+					halves[(vertex_id >> dim) & 1][subcube_table::half_index(vertex_id, dim)] = subcube_table::half_index(matching[vertex_id], dim);
+				}
+				half_rank[dim][0] = subcube_table::rank(halves[0].data(), MATCH_SIZE);
+				half_rank[dim][1] = subcube_table::rank(halves[1].data(), MATCH_SIZE);
+			}
+		}
+		//prepare components - every edge of the matching is a component (a path of length 1) with root in its lower vertex:
 		FOR_VERTICES(vertex_id) {
-			actual_path.found_path[vertex_id] = INVALID;
-			if (actual_path.base_matching[vertex_id] > vertex_id) {
+			if (matching[vertex_id] > vertex_id) {
 				sfi first_vertex = vertex_id;
-				sfi second_vertex = actual_path.base_matching[vertex_id];
-				//setting new component for this edge:
-				vertex_component[first_vertex] = component_id;
-				vertex_component[second_vertex] = component_id;
-				component_id++;
+				sfi second_vertex = matching[vertex_id];
+				base.component_parent[first_vertex] = first_vertex;
+				base.component_parent[second_vertex] = first_vertex;
+				base.component_size[first_vertex] = 2;
+				base.component_ends[first_vertex] = edge(first_vertex, second_vertex);
 				//setting neighbours_bitmap (if the edge is from Q_n, we cannot use that edge, otherwise we can use any edge):
 				if (hamming[first_vertex ^ second_vertex] == 1) {
-					neighbours_bitmap[first_vertex] = DIMENSION_BITS ^ (first_vertex ^ second_vertex);
-					neighbours_bitmap[second_vertex] = DIMENSION_BITS ^ (first_vertex ^ second_vertex);
+					base.neighbours_bitmap[first_vertex] = DIMENSION_BITS ^ (first_vertex ^ second_vertex);
+					base.neighbours_bitmap[second_vertex] = DIMENSION_BITS ^ (first_vertex ^ second_vertex);
 				}
 				else {
-					neighbours_bitmap[first_vertex] = DIMENSION_BITS;
-					neighbours_bitmap[second_vertex] = DIMENSION_BITS;
+					base.neighbours_bitmap[first_vertex] = DIMENSION_BITS;
+					base.neighbours_bitmap[second_vertex] = DIMENSION_BITS;
 				}
 			}
 		}
-		//prepare component_sizes:
-		for (sfi i = 0; i < MATCH_SIZE; i++) {
-			component_sizes[i] = 2;
-		}
+	}
+
+	void pathfinding::prepare_data() {
+		//The components of the matching are copied from the prepared state
+		component_parent = base.component_parent;
+		component_size = base.component_size;
+		component_ends = base.component_ends;
+		neighbours_bitmap = base.neighbours_bitmap;
+		actual_path.found_path.fill(INVALID);
+		union_count = 0;
 		//adding "edge" start_vertex->end_vertex (simulates that start_vertex and end_vertex are not connectable)
 		add_edge(actual_path.start_vertex, actual_path.end_vertex);
 	}
 
 	void pathfinding::add_edge(sfi first_vertex, sfi second_vertex) {
+		sfi first_root = find_component(first_vertex);
+		sfi second_root = find_component(second_vertex);
 #ifdef _DEBUG
 		//Check that adding this edge is valid
-		if (vertex_component[first_vertex] == vertex_component[second_vertex])
+		if (first_root == second_root)
 			errors::assert_error("Chosen edge would connect same components!");
 		if (actual_path.found_path[first_vertex] != INVALID || actual_path.found_path[second_vertex] != INVALID)
 			errors::assert_error("Chosen vertex is not external!");
 #endif //_DEBUG
 
-		sfi new_component_id = vertex_component[first_vertex];
-		sfi old_component_id = vertex_component[second_vertex];
-
-		//rename the smaller component
-		if (component_sizes[old_component_id] > component_sizes[new_component_id]) {
-			std::swap(first_vertex, second_vertex);
-			std::swap(old_component_id, new_component_id);
-		}
-		sfi old_component_size = component_sizes[old_component_id];
-
-		//Component sizes actualization
-		component_sizes[new_component_id] += old_component_size;
-		component_sizes[old_component_id] = 0;		
-		sfi actual_vertex = actual_path.base_matching[second_vertex];
-		vertex_component[second_vertex] = new_component_id;
-		vertex_component[actual_vertex] = new_component_id;
-
-		//Change of component numbers for all vertices from second_vertex component
-		while (actual_path.found_path[actual_vertex] != INVALID) {
-			actual_vertex = actual_path.found_path[actual_vertex];
-			vertex_component[actual_vertex] = new_component_id;
-			actual_vertex = actual_path.base_matching[actual_vertex];
-			vertex_component[actual_vertex] = new_component_id;	
-		}
-
-		for (sfi dim = 1; dim < VERTICES; dim <<= 1) {
-			//Check if new endpoints of this component are neighbours
-			if (vertex_component[actual_vertex ^ dim] == new_component_id && actual_path.found_path[actual_vertex ^ dim] == INVALID) {
-				neighbours_bitmap[actual_vertex] &= ~dim;
-				neighbours_bitmap[actual_vertex ^ dim] &= ~dim;
-			}
-		}
-		//Removing external status from start_vertex, end_vertex 
+		//The endpoints of the merged component are the other endpoints of both components
+		sfi first_end = other_end(first_root, first_vertex);
+		sfi second_end = other_end(second_root, second_vertex);
+
+		//Union by size, the smaller root is attached to the larger one
+		if (component_size[first_root] < component_size[second_root])
+			std::swap(first_root, second_root);
+		union_record & record = union_history[union_count++];
+		record.child = second_root;
+		record.root_ends = component_ends[first_root];
+		component_parent[second_root] = first_root;
+		component_size[first_root] += component_size[second_root];
+		component_ends[first_root] = edge(first_end, second_end);
+
+		//Check if new endpoints of this component are neighbours
+		if (hamming[first_end ^ second_end] == 1) {
+			neighbours_bitmap[first_end] &= ~(first_end ^ second_end);
+			neighbours_bitmap[second_end] &= ~(first_end ^ second_end);
+		}
+		//Removing external status from first_vertex, second_vertex
 		for (sfi dim = 1; dim < VERTICES; dim <<= 1) {
 			neighbours_bitmap[first_vertex ^ dim] &= ~dim;
 			neighbours_bitmap[second_vertex ^ dim] &= ~dim;
@@ -315,95 +776,51 @@ namespace cube {
 		//Finally, add the edge into path
 		actual_path.found_path[first_vertex] = second_vertex;
 		actual_path.found_path[second_vertex] = first_vertex;
-
-#ifdef _DEBUG
-		//Check that component sizes were not corrupted
-		vertices_array numbers;
-		FOR_EDGES(component_id) {
-			numbers[component_id] = 0;
-		}
-		FOR_VERTICES(vertex_id) {
-			numbers[vertex_component[vertex_id]]++;
-		}
-		FOR_EDGES(component_id) {
-			if (component_sizes[component_id] != numbers[component_id])
-				errors::assert_error("numbers of vertices in components does not match the values in component_sizes!");
-		}
-#endif //_DEBUG
 	}
 
 	void pathfinding::remove_edge(const sfi first_vertex, const sfi second_vertex) {
-		sfi old_component_id = vertex_component[first_vertex];
-		sfi new_component_id = 1;
-		//Selecting some free component_id (there is always at least one)
-		while (component_sizes[new_component_id] > 0) 
-			new_component_id++;
-		sfi actual_vertex = actual_path.base_matching[second_vertex];
-		vertex_component[second_vertex] = new_component_id;
-		vertex_component[actual_vertex] = new_component_id;
-		sfi length = 1;
-		//Revert numbers of component to disjoint
-		while (actual_path.found_path[actual_vertex] != INVALID) {		
-			actual_vertex = actual_path.found_path[actual_vertex];
-			vertex_component[actual_vertex] = new_component_id;
-			actual_vertex = actual_path.base_matching[actual_vertex];
-			vertex_component[actual_vertex] = new_component_id;
-			length++;
-		}
-		//Switch component sizes to new state
-		component_sizes[old_component_id] -= (length << 1);
-		component_sizes[new_component_id] += (length << 1);
+		//Undo the last union (edges are removed in reverse order of adding)
+		const union_record & record = union_history[--union_count];
+		sfi root = component_parent[record.child];
+		sfi first_end = component_ends[root].first;
+		sfi second_end = component_ends[root].second;
+		component_parent[record.child] = record.child;
+		component_size[root] -= component_size[record.child];
+		component_ends[root] = record.root_ends;
 
 		//Remove the edge
 		actual_path.found_path[first_vertex] = INVALID;
 		actual_path.found_path[second_vertex] = INVALID;
 
 		//Set neighbours_bitmap to new state
-		//Enable edge (if exists) between ends of initial component 
-		for (sfi dim = 1; dim < VERTICES; dim <<= 1) {
-			if (actual_path.found_path[actual_vertex ^ dim] == INVALID && vertex_component[actual_vertex ^ dim] == old_component_id) {
-				neighbours_bitmap[actual_vertex] |= dim;
-				neighbours_bitmap[actual_vertex ^ dim] |= dim;
-				//This edge is only one, thus we may break the search
-				break;
-			}
+		//Enable edge (if exists) between ends of the merged component 
+		if (hamming[first_end ^ second_end] == 1) {
+			neighbours_bitmap[first_end] |= (first_end ^ second_end);
+			neighbours_bitmap[second_end] |= (first_end ^ second_end);
 		}
 
-		//Allow edges from start_vertex, end_vertex (we need to check that the edge is not in the same component)
+		//Allow edges from first_vertex, second_vertex (we need to check that the edge is not in the same component)
+		sfi first_root = find_component(first_vertex);
+		sfi second_root = find_component(second_vertex);
 		for (sfi dim = 1; dim < VERTICES; dim <<= 1) {
-			if (actual_path.found_path[first_vertex ^ dim] == INVALID && vertex_component[first_vertex ^ dim] != old_component_id) {
+			if (actual_path.found_path[first_vertex ^ dim] == INVALID && find_component(first_vertex ^ dim) != first_root) {
 				neighbours_bitmap[first_vertex] |= dim;
 				neighbours_bitmap[first_vertex ^ dim] |= dim;
 			}
 			else
 				neighbours_bitmap[first_vertex] &= ~dim;
 
-			if (actual_path.found_path[second_vertex ^ dim] == INVALID && vertex_component[second_vertex ^ dim] != new_component_id) {
+			if (actual_path.found_path[second_vertex ^ dim] == INVALID && find_component(second_vertex ^ dim) != second_root) {
 				neighbours_bitmap[second_vertex] |= dim;
 				neighbours_bitmap[second_vertex ^ dim] |= dim;
 			}
 			else
 				neighbours_bitmap[second_vertex] &= ~dim;
 		}
-
-
-#ifdef _DEBUG
-		//Check that component sizes were not corrupted
-		vertices_array numbers;
-		FOR_EDGES(component_id) {
-			numbers[component_id] = 0;
-		}
-		FOR_VERTICES(vertex_id) {
-			numbers[vertex_component[vertex_id]]++;
-		}
-		FOR_EDGES(component_id) {
-			if (component_sizes[component_id] != numbers[component_id])
-				errors::assert_error("Numbers of vertices in components does not match the values in component_sizes!");
-		}
-#endif //_DEBUG
 	}
 
 	void pathfinding::choose_next(sfi edges_added) {
+		nodes++;
 		//If done except the last edge, check it and then finish the path with it.
 		if (edges_added == MATCH_SIZE - 2) { 
 			sfi first_external;
@@ -429,25 +846,52 @@ namespace cube {
 			//find the most constrained vertex
 			sfi posibilities_count = DIMENSION; //larger than any possible result
 			sfi best_vertex = 0;
+#ifdef FORWARD_CHECKING
+			//Vertices with single possibility are connected immediately during the scan (all of them at once), a vertex without any possibility ends the search
+			sfi forced_cnt = 0;
+			std::array<edge, MATCH_SIZE> forced_edges;
+			bool dead_end = false;
+#endif //FORWARD_CHECKING
 			FOR_VERTICES(vertex_id) {
+#ifdef FORWARD_CHECKING
+				//The last edge is checked separately
+				if (edges_added + forced_cnt == MATCH_SIZE - 2)
+					break;
+				if (actual_path.found_path[vertex_id] == INVALID && hamming[neighbours_bitmap[vertex_id]] <= 1) {
+					if (neighbours_bitmap[vertex_id] == 0) {
+						dead_end = true;
+						break;
+					}
+					sfi neighbour = vertex_id ^ neighbours_bitmap[vertex_id];
+					add_edge(vertex_id, neighbour);
+					forced_edges[forced_cnt++] = edge(vertex_id, neighbour);
+					continue;
+				}
+#endif //FORWARD_CHECKING
 				if (actual_path.found_path[vertex_id] == INVALID && hamming[neighbours_bitmap[vertex_id]] < posibilities_count) {
 					posibilities_count = hamming[neighbours_bitmap[vertex_id]];
 					best_vertex = vertex_id;
 				}
 			}
+#ifdef FORWARD_CHECKING
+			//The state was changed by forced edges, continue with a new scan (unless the partial path cannot be completed)
+			if (dead_end || forced_cnt > 0) {
+				if (!dead_end)
+					choose_next(edges_added + forced_cnt);
+				//If not done, remove the forced edges again
+				if (!actual_path.has_solution) {
+					for (sfi forced_id = forced_cnt; forced_id > 0; forced_id--) {
+						remove_edge(forced_edges[forced_id - 1].first, forced_edges[forced_id - 1].second);
+					}
+				}
+				return;
+			}
+#endif //FORWARD_CHECKING
 			//Try to match it with all possible neighbours
 			for (sfi neighbour = 1; neighbour < VERTICES; neighbour <<= 1) {
 				if (neighbours_bitmap[best_vertex] & neighbour) {
-					//select the lesser component to be renumbered
-					sfi first_vertex, second_vertex;
-					if (component_sizes[vertex_component[best_vertex]] >= component_sizes[vertex_component[best_vertex ^ neighbour]]) {
-						first_vertex = best_vertex;
-						second_vertex = best_vertex ^ neighbour;
-					}
-					else {
-						first_vertex = best_vertex ^ neighbour;
-						second_vertex = best_vertex;
-					}
+					sfi first_vertex = best_vertex;
+					sfi second_vertex = best_vertex ^ neighbour;
 					add_edge(first_vertex, second_vertex);
 					choose_next(edges_added + 1);
 					//If done, propagate result
@@ -459,13 +903,4 @@ namespace cube {
 			}
 		}
 	}
-
-	path pathfinding::actual_path;
-	vertices_array pathfinding::vertex_component;
-	std::array<sfi, MATCH_SIZE> pathfinding::component_sizes;
-	vertices_array pathfinding::neighbours_bitmap;
-	bool pathfinding::all_parallel;
-	llfi pathfinding::bad_num = 0;
-	llfi pathfinding::counterexamples = 0;
-
 }
\ No newline at end of file
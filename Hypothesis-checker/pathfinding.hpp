@@ -5,77 +5,318 @@
 #include "path.hpp"
 #include "errors.hpp"
 #include "matchings.hpp"
+#include "containers.hpp"
+#include "scheduler.hpp"
+#include "automorphisms.hpp"
+#include "bitboard.hpp"
+#include "subcube_table.hpp"
+#include "cost_model.hpp"
+#include "path_sink.hpp"
 #include <algorithm>
 #include <array>
 #include <vector>
+#include <string>
+#include <iterator>
 #include <iostream>
+#include <sstream>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <condition_variable>
 
 namespace cube {
-	/* Provides functions to find paths for any set of perfect matching in B(2^d) for all pair of vertices in opposite partities as its endpoints. Includes analysis of failed cases in respect to the hypothesis. */
+	/* Provides functions to find paths for any set of perfect matching in B(2^d) for all pair of vertices in opposite partities as its endpoints. Includes analysis of failed cases in respect to the hypothesis.
+	   The matchings are solved in parallel - they are ordered by the cost estimated by cost_model (the most expensive first), split into tasks and every worker solves them with its own instance (solver context) of this class.
+	   The outputs of matchings are merged in the order of sequential iteration (the matchings are ordered by cost only within windows of PATHFINDING_SCHEDULE_WINDOW matchings, which limits the outputs waiting for the merge),
+	   thus the report and results do not depend on the number of threads.
+	   A matching which needs more than STRAGGLER_NODES nodes of the search is a straggler, its remaining pairs of ending vertices are split into chunks solved by idle workers too.
+	   The found paths of such a matching may then depend on the workers which solved them (has_solution and the report do not). */
 	class pathfinding {
 	public:
 		/* Tries to find Hamiltonian paths for every pair of vertices in opposite partities (except the connected ones) composed of given perfect matching and edges from Q_n for all matchings given as a parameter.
-		   Returns an array of all results, either found path (has_solution=true) or information about failure (has_solution=false). Tests the failures if they fulfill the hypothesis.
-		   Warning: The result size is much larger than input, thus this function is not suitable for all posible matchings. */
-		static std::vector<path> find_paths(const result_set & matchings);
+		   The results of every matching (either found path with has_solution=true or information about failure with has_solution=false) are passed to the sink, only the matchings with a failure
+		   are passed unless the sink needs all of them. Tests the failures if they fulfill the hypothesis.
+		   If cost_log_file is not empty, the features and the observed cost of every matching are written into it (see cost_model). */
+		static void find_paths(const result_set & matchings, path_sink & sink, size_t threads = default_thread_count(), solver_type solver = solver_type::SEARCH, const std::string & cost_log_file = std::string());
 
-		/* Tries to find Hamiltonian paths for every pair of vertices in opposite partities (except the connected ones) composed of given perfect matching and edges from Q_n for all matchings given as a parameter.
-		   Returns an array of all results of those matchings, in which at least one failure was found. Tests the failures if they fulfill the hypothesis. */
-		static std::vector<path> find_unsolved_paths(const result_set & matchings);
+		/* Creates empty solver context. */
+		pathfinding() : solver(solver_type::SEARCH), scheduler(nullptr), worker_id(0), nodes(0), split_dims(0), split_hits(0), split_misses(0), union_count(0), pool_size(0), pool_next(0), all_parallel(false), bad_num(0), counterexamples(0) {}
+
+		/* Prepares the data used for search of all pairs of ending vertices of given matching (for the selected engine). */
+		void prepare_matching(const perfect_matching & matching);
+
+		/* Returns whether there is a Hamiltonian path for given matching (it has to be prepared) and ending vertices and stores it into found_path, the path is not checked against the hypothesis. */
+		bool has_path(const perfect_matching & matching, sfi start_vertex, sfi end_vertex, perfect_matching & found_path);
 
 	private:
+		/* Remaining pairs of ending vertices of a straggler matching, they are solved in chunks by its worker and by the workers helping it. */
+		struct straggler {
+			straggler() : next_chunk(0), done_chunks(0), nodes(0) {}
+
+			//The matching
+			perfect_matching matching;
+			//Pairs of ending vertices to be solved and their results
+			std::vector<edge> pairs;
+			std::vector<path> results;
+			//Number of chunks, the next chunk to be taken and the number of solved chunks
+			size_t chunks_cnt;
+			std::atomic<size_t> next_chunk;
+			std::atomic<size_t> done_chunks;
+			//Number of nodes of the search of all chunks
+			std::atomic<llfi> nodes;
+			//Signal for the owner of the matching that the last chunk was solved
+			std::mutex lock;
+			std::condition_variable finished;
+		};
+
+		/* Matching scheduled for the pathfinding. */
+		struct scheduled_matching {
+			//Order of the matching in sequential iteration
+			llfi index;
+			//The compressed matching
+			llfi compressed;
+			//Estimated cost of the matching
+			double cost;
+			//Stabilizer found by the estimation (empty if only the identity maps the matching onto itself)
+			std::vector<automorphism_id> stabilizer;
+		};
+
+		/* Range of scheduled matchings solved at once by a single worker (or a request to help with a straggler matching if split is set). */
+		struct solver_task {
+			llfi begin;
+			llfi end;
+			//Straggler matching to help with
+			std::shared_ptr<straggler> split;
+		};
+
+		/* Outputs of a solved matching. */
+		struct matching_output {
+			//Order of the matching in sequential iteration
+			llfi index;
+			//Text written to std::cout during the solving
+			std::string report;
+			//Line of the calibration log
+			std::string log;
+			//Found paths
+			std::vector<path> paths;
+		};
+
+		/* Outputs of a finished task, only the matchings with some output are stored. */
+		struct task_output {
+			task_output() : counterexamples(0) {}
+
+			std::vector<matching_output> matchings;
+			//Number of counterexamples found
+			llfi counterexamples;
+		};
+
+		/* Solves all matchings using given number of threads and engine, passes their results to the sink and returns the number of found counterexamples. */
+		static llfi solve_all(const result_set & matchings, path_sink & sink, size_t threads, solver_type solver, const std::string & cost_log_file);
+
+		/* Estimates the costs of given range of scheduled matchings and stores their stabilizers. */
+		void estimate_task(std::vector<scheduled_matching> & schedule, llfi begin, llfi end);
+
+		/* Solves given range of scheduled matchings, the lines of the calibration log are written only if log_costs is true. */
+		void solve_task(const std::vector<scheduled_matching> & schedule, llfi begin, llfi end, bool log_costs, task_output & output);
+
+		/* Splits the pairs of ending vertices of the matching following the given one (only the representatives of their orbits with SYMMETRY_REDUCTION) into tasks for idle workers.
+		   Solves the chunks of pairs together with them and returns the results when all of them are solved. */
+		std::shared_ptr<straggler> split_matching(const perfect_matching & matching, sfi start_vertex, sfi end_vertex);
+
+		/* Prepares given straggler matching of other worker and solves its chunks of pairs which are not taken yet. */
+		void help(straggler & split);
+
+		/* Solves the chunks of pairs of the straggler matching which are not taken yet (the matching has to be prepared). */
+		void solve_chunks(straggler & split);
+
 		/* Sets all_parallel to true iff all edges of the matching crosses first dimension (all matchings in minimal form with at least one edge from hypercube has edge 0->1). */
-		static void check_one_dimension(const perfect_matching & matching);
+		void check_one_dimension(const perfect_matching & matching);
 
 		/* Tests failed path to fulfil hypothesis. */
-		static void check_hypothesis(path & failed_path);
+		void check_hypothesis(path & failed_path);
 
 		/* Checks if the number of unsolved paths respects expected number if any failure was found for a matching. */
-		static void number_check();
+		void number_check();
+
+		/* Tries to find Hamiltonian path for given matching and ending vertices in actual_path using the selected engine. */
+		void solve();
+
+		/* Finds all automorphisms which map the matching onto itself and stores them into stabilizer. */
+		void find_stabilizer(const perfect_matching & matching);
+
+		/* Returns the automorphism from the stabilizer mapping given pair onto the smallest pair of its orbit (0 if the pair is the smallest one) and stores the smallest pair. */
+		automorphism_id find_representative(sfi start_vertex, sfi end_vertex, edge & smallest_pair) const;
+
+		/* Sets the solution of actual_path to the solution of the representative mapped back by the inverse of given automorphism. */
+		void map_representative(automorphism_id transform_id, const path & representative);
+
+		/* Same as solve, but only the smallest pair of the orbit of ending vertices under the stabilizer is solved, the solution of any other pair is obtained from it by an automorphism. */
+		void solve_symmetric();
+
+#ifdef SOLUTION_POOL
+		/* Tries to obtain the solution of actual_path from the pool of found paths of the matching, returns whether it succeeded.
+		   A path closed by an edge from Q_n is a cycle which gives the path for ending vertices of any its edge. If the pairs share an ending vertex, the other one is moved by an exchange -
+		   the edge of new ending vertex and its neighbour on the path and one more edge of the path are replaced by the edges to the old ending vertex and to the neighbour.
+		   A rotation (a single replaced edge) is not tried, the ending vertices of a valid pair have opposite parities, thus the rotated path always splits into a path and a cycle. */
+		bool reuse_solution();
+
+		/* Adds the solution in actual_path to the pool, the oldest one is replaced if the pool is full. */
+		void pool_solution();
+
+		/* Returns whether the base matching and found_path of actual_path form a single cycle through all vertices. */
+		bool is_hamiltonian_cycle() const;
+#endif //SOLUTION_POOL
 
-		/* Tries to find Hamiltonian path for given matching and ending vertices in actual_path. */
-		static void solve();
+		/* Tries to construct the path for actual_path from the paths of both halves of Q_n split along a dimension which is not crossed by the matching, returns whether it succeeded.
+		   If the table of subcubes contains a path from start_vertex to some x in its half and from the neighbour of x to end_vertex in the other half,
+		   the path is composed of both of them and of the edge between x and its neighbour. */
+		bool solve_split();
 
-		/* Analyses actual_path and prepares data used for search. */
-		static void prepare_data();
+		/* Adds the edges from Q_n of the encoded path of the table of subcubes between given vertices of a half of Q_n split along given dimension into actual_path. */
+		void add_half_path(sfi dim, subcube_table::path_code code, sfi first_vertex, sfi second_vertex);
+
+#ifdef _DEBUG
+		/* Checks that the solution in actual_path (if there is any) is a Hamiltonian path. */
+		void check_solution();
+#endif //_DEBUG
+
+		/* Prepares data used for search of actual_path from the data of its matching. */
+		void prepare_data();
 
 		/* Adds selected edge to partial path and properly actualizes search data.
-		   Component number of second_vertex will be changed to component number of first vertex. */
-		static void add_edge(sfi first_vertex, sfi second_vertex);
+		   The components of both vertices are united, the new endpoints are taken from component_ends in constant time. */
+		void add_edge(sfi first_vertex, sfi second_vertex);
+
+		/* Removes selected edge from partial path and properly actualizes search data.
+		   It must be the last added edge, the union of its components is undone. */
+		void remove_edge(const sfi first_vertex, const sfi second_vertex);
 
-		/* Removes selected edge from partial path and properly actualizes search data 
-		   The component of second vertex will get new component number. */
-		static void remove_edge(const sfi first_vertex, const sfi second_vertex);
+		/* Returns the root of the component of given vertex. */
+		sfi find_component(sfi vertex_id) const {
+			while (component_parent[vertex_id] != vertex_id)
+				vertex_id = component_parent[vertex_id];
+			return vertex_id;
+		}
+
+		/* Returns the endpoint of component with given root different from given endpoint. */
+		sfi other_end(const sfi root, const sfi endpoint) const {
+			return (component_ends[root].first == endpoint) ? component_ends[root].second : component_ends[root].first;
+		}
 
 		/* Tries to recursively find edges from Q_n to complete the path.
-		   Always selects the most constrained vertex to continue - this reduces the branching factor of search. */
-		static void choose_next(sfi edges_added);
+		   Always selects the most constrained vertex to continue - this reduces the branching factor of search.
+		   With FORWARD_CHECKING, the vertices with single possibility are connected at once and the search is stopped at a vertex without any possibility. */
+		void choose_next(sfi edges_added);
+
+
+		/* Used data structures (of a solver context): */		
 
+		/* Selected engine of the search. */
+		solver_type solver;
 
-		/* Used data structures: */		
+		/* Scheduler of the tasks (used to split straggler matchings) and the worker using this context. */
+		task_scheduler<solver_task> * scheduler;
+		size_t worker_id;
+
+		/* Number of expanded nodes of the search. */
+		llfi nodes;
+
+		/* The bitboard engine (used if it is selected). */
+		bitboard_solver bitboard;
+
+		/* Dimensions not crossed by any edge of actual matching (if the table of subcubes is loaded) and the ranks of matchings of both halves of Q_n split along them. */
+		sfi split_dims;
+		std::array<std::array<llfi, 2>, DIMENSION> half_rank;
+
+		/* Numbers of pairs constructed from the table of subcubes and of pairs passed to other engines. */
+		llfi split_hits;
+		llfi split_misses;
 
 		/* Structure holding actual path with initial matching and ending vertices. */
-		static path actual_path;
+		path actual_path;
+
+		/* Union-find of components of partial path (paths composed of edges of the matching and of the partial path), component_parent[v] is v for roots.
+		   Union by size without path compression is used, thus every union may be undone in constant time and find_component takes O(log n). */
+		vertices_array component_parent;
+
+		/* Number of vertices of the component, valid for roots only. */
+		vertices_array component_size;
 
-		/* Excipient structure holding number of component for each vertex in partial path. 
-		Vertices in different components will have different numbers, but used numbers are not necessarily consequent. */
-		static vertices_array vertex_component;
+		/* Both endpoints (external vertices) of the component, valid for roots only. */
+		std::array<edge, VERTICES> component_ends;
 
-		/* Sizes of components - for index i, there will be the number of vertices with component number i in component_sizes[i]. */
-		static std::array<sfi, MATCH_SIZE> component_sizes;
+		/* Information needed to undo a union. */
+		struct union_record {
+			//Root attached to other root
+			sfi child;
+			//Endpoints of the other root before the union
+			edge root_ends;
+		};
+
+		/* Stack of performed unions, one for every edge of partial path. */
+		std::array<union_record, MATCH_SIZE> union_history;
+
+		/* Number of unions in union_history. */
+		sfi union_count;
+
+		/* Search data of actual matching before the ending vertices are connected, prepared once for all its pairs. */
+		struct base_state {
+			vertices_array component_parent;
+			vertices_array component_size;
+			std::array<edge, VERTICES> component_ends;
+			vertices_array neighbours_bitmap;
+		};
+		base_state base;
+
+		/* Found path of actual matching kept in the pool. */
+		struct pooled_solution {
+			//Ending vertices of the path
+			edge ends;
+			//Complement matching of the path
+			perfect_matching found_path;
+		};
+
+		/* Pool of the last found paths of actual matching. */
+		std::array<pooled_solution, SOLUTION_POOL_SIZE> pool;
+
+		/* Number of paths in the pool and the position of the next one. */
+		sfi pool_size;
+		sfi pool_next;
+
+		/* Numbers of pairs solved by the pool (directly from a cycle or after an exchange of two edges) and of pairs searched. */
+		struct pool_statistics {
+			pool_statistics() : direct_hits(0), exchange_hits(0), misses(0) {}
+
+			llfi direct_hits;
+			llfi exchange_hits;
+			llfi misses;
+		};
+		pool_statistics pool_stats;
 
 		/* Bitmap of all neighbours availble to be connected to vertex i - 
 		   e.g. if neighbours_bitmap[i] = 9=(01001)_2, it means that add_edge(i, i XOR 1) and add_edge(i, i XOR 8) are the only possibilities how to continue from i.*/
-		static vertices_array neighbours_bitmap;	
+		vertices_array neighbours_bitmap;	
 
 		/* Whether all edges in the matching the matching crosses same dimension - used for determining the type of the matching. */
-		static bool all_parallel;
+		bool all_parallel;
 
 		/* The number of unsolved paths of actual matching. */
-		static size_t bad_num;
+		size_t bad_num;
+
+		/* Number of configurations violating hypothesis in actual task - the total must be zero for proving it. */
+		llfi counterexamples;
+
+		/* Automorphisms mapping actual matching onto itself (the identity is the first one). */
+		std::vector<automorphism_id> stabilizer;
+
+		/* Solved representatives of orbits of ending vertices of actual matching, indexed by start_vertex * VERTICES + end_vertex. */
+		std::array<path, VERTICES * VERTICES> representatives;
 
-		/* Total number of configurations violating hypothesis - must be zero for proving it. */
-		static llfi counterexamples;
+		/* Text written during actual task, it is written to std::cout when all previous tasks are done. */
+		std::ostringstream report;
 
 		/* The expected number of unsolved configurations when the input matching has type 1. */
 		static const sfi TYPE1_CNT = MATCH_SIZE * ((MATCH_SIZE >> 1) - 1);
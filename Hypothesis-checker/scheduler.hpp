@@ -0,0 +1,131 @@
+#ifndef SCHEDULER_
+#define SCHEDULER_
+
+#include "settings.hpp"
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+
+namespace cube {
+	/* Returns the number of worker threads to be used when the user does not select it (at least 1). */
+	inline size_t default_thread_count() {
+		size_t count = std::thread::hardware_concurrency();
+		return (count == 0) ? 1 : count;
+	}
+
+	/* Simple work-stealing scheduler. Every worker owns a double-ended queue of tasks, takes tasks from its back and when it runs out of work, it steals from the front of other queues.
+	   Tasks may be pushed before run() is called (they are distributed among the workers) as well as by the workers themselves during run(). */
+	template<class task>
+	class task_scheduler {
+	public:
+		/* Creates scheduler for given number of workers. */
+		explicit task_scheduler(size_t workers) : queues(workers == 0 ? 1 : workers), next_queue(0), pending(0), steals_(0) {}
+
+		/* Adds task to queue of selected worker. */
+		void push(size_t worker_id, task && new_task) {
+			pending++;
+			std::lock_guard<std::mutex> lock(queues[worker_id].lock);
+			queues[worker_id].tasks.push_back(std::move(new_task));
+		}
+
+		/* Adds task to the front of queue of selected worker, thus it is the first one stolen by other workers. */
+		void push_front(size_t worker_id, task && new_task) {
+			pending++;
+			std::lock_guard<std::mutex> lock(queues[worker_id].lock);
+			queues[worker_id].tasks.push_front(std::move(new_task));
+		}
+
+		/* Adds task to the queues in round-robin manner (used for initial distribution of work). */
+		void push(task && new_task) {
+			push(next_queue, std::move(new_task));
+			next_queue = (next_queue + 1) % queues.size();
+		}
+
+		/* Runs worker(worker_id, task) for all tasks (including the ones pushed meanwhile) on workers() threads and returns when all of them are finished. */
+		template<class function>
+		void run(function worker) {
+			std::vector<std::thread> threads;
+			for (size_t worker_id = 1; worker_id < queues.size(); worker_id++) {
+				threads.push_back(std::thread([this, worker_id, &worker]() { work(worker_id, worker); }));
+			}
+			//The calling thread is used as worker 0
+			work(0, worker);
+			for (size_t thread_id = 0; thread_id < threads.size(); thread_id++) {
+				threads[thread_id].join();
+			}
+		}
+
+		/* Returns number of workers. */
+		size_t workers() const {
+			return queues.size();
+		}
+
+		/* Returns the number of tasks taken from other worker's queue during last run(). */
+		llfi steals() const {
+			return steals_;
+		}
+
+	private:
+		/* Queue of single worker. */
+		struct worker_queue {
+			std::mutex lock;
+			std::deque<task> tasks;
+		};
+
+		/* Main loop of a worker - process own tasks, then try to steal until there is no pending task. */
+		template<class function>
+		void work(size_t worker_id, function & worker) {
+			task actual_task;
+			while (pending > 0) {
+				if (pop(worker_id, actual_task) || steal(worker_id, actual_task)) {
+					worker(worker_id, actual_task);
+					//Tasks pushed by the worker were already counted, thus the scheduler may finish only after this point.
+					pending--;
+				}
+				else
+					std::this_thread::yield();
+			}
+		}
+
+		/* Takes task from the back of own queue. */
+		bool pop(size_t worker_id, task & result) {
+			std::lock_guard<std::mutex> lock(queues[worker_id].lock);
+			if (queues[worker_id].tasks.empty())
+				return false;
+			result = std::move(queues[worker_id].tasks.back());
+			queues[worker_id].tasks.pop_back();
+			return true;
+		}
+
+		/* Takes task from the front of some other queue. */
+		bool steal(size_t worker_id, task & result) {
+			for (size_t offset = 1; offset < queues.size(); offset++) {
+				worker_queue & victim = queues[(worker_id + offset) % queues.size()];
+				std::lock_guard<std::mutex> lock(victim.lock);
+				if (!victim.tasks.empty()) {
+					result = std::move(victim.tasks.front());
+					victim.tasks.pop_front();
+					steals_++;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		//Queues of all workers
+		std::vector<worker_queue> queues;
+
+		//Queue used by next call of push without selected worker
+		size_t next_queue;
+
+		//Number of pushed but not yet finished tasks
+		std::atomic<llfi> pending;
+
+		//Number of stolen tasks
+		std::atomic<llfi> steals_;
+	};
+}
+
+#endif //SCHEDULER_
@@ -1,63 +1,268 @@
 #include "serializer.hpp"
 
 namespace cube {
-	result_set serializer::load_matchings(const std::string file_name) {
-		//tries to open selected file
-		input_file.open(file_name); 
-		if (input_file.fail())
-			errors::input_error("An error occured when opening " + file_name);
+	result_set serializer::load_matchings(const std::string file_name, bool trusted, size_t threads) {
+		input_view view;
+		open_view(file_name, view);
 
-		result_set found_matchings;
-		while (true) {
-			std::string line;
-			next_line(line);
-			
-			if (input_file.fail()) {
-				//file read failed - if it was not due to EOF, there was some error
-				if (input_file.eof())
-					break;
-				else
-					errors::input_error("Unexpected error while reading input file!");
+		//Every chunk parses the lines starting in its range of bytes, so no line is split between two chunks
+		llfi chunks_cnt = (view.size + LOAD_CHUNK_BYTES - 1) / LOAD_CHUNK_BYTES;
+		std::vector<text_chunk> chunks(chunks_cnt);
+		run_chunks(chunks_cnt, threads, [&](llfi chunk_id) {
+			text_chunk & chunk = chunks[chunk_id];
+			const char * position = line_start(view, chunk_id * LOAD_CHUNK_BYTES);
+			const char * last = line_start(view, (chunk_id + 1) * LOAD_CHUNK_BYTES);
+			perfect_matching matching;
+			while (position < last) {
+				const char * line_end = (const char *)std::memchr(position, '\n', last - position);
+				if (line_end == nullptr)
+					line_end = last;
+				chunk.lines++;
+				//Skipping empty lines
+				if (line_end - position > 1 || (line_end - position == 1 && *position != '\r')) {
+					if (!parse_matching(position, line_end, matching, chunk.error))
+						return true;
+					chunk.matchings.push_back(compress(matching));
+				}
+				position = line_end + 1;
 			}
-		
-			//Deserialize the matching
-			perfect_matching match = parse_matching(line);
-			found_matchings.insert(compress(match));
+			return true;
+		});
+		close_view(view);
+
+		//The first error of the file is reported with its line
+		llfi lines = 0;
+		for (llfi chunk_id = 0; chunk_id < chunks_cnt; chunk_id++) {
+			lines += chunks[chunk_id].lines;
+			if (!chunks[chunk_id].error.empty())
+				errors::input_error(chunks[chunk_id].error + " (line " + std::to_string(lines) + ")");
 		}
-		input_file.close();
-		return std::move(found_matchings);
-	}
 
-	result_set serializer::load_comp_matchings(const std::string file_name) { //TODO
-		//tries to open selected file
-		input_file.open(file_name, std::ios::in | std::ios::binary);
-		if (input_file.fail())
-			errors::input_error("An error occured when opening " + file_name);
+		if (trusted) {
+			std::vector<llfi> trusted_matchings;
+			for (llfi chunk_id = 0; chunk_id < chunks_cnt; chunk_id++) {
+				trusted_matchings.insert(trusted_matchings.end(), chunks[chunk_id].matchings.begin(), chunks[chunk_id].matchings.end());
+				std::vector<llfi>().swap(chunks[chunk_id].matchings);
+			}
+			result_set found_matchings;
+			found_matchings.assign_flat(std::move(trusted_matchings));
+			return found_matchings;
+		}
+		return load_chunks(chunks_cnt, threads, [&](llfi chunk_id, result_set_builder & builder) {
+			builder.add(chunk_id, chunks[chunk_id].matchings.data(), chunks[chunk_id].matchings.data() + chunks[chunk_id].matchings.size());
+			std::vector<llfi>().swap(chunks[chunk_id].matchings);
+			return true;
+		});
+	}
 
+	result_set serializer::load_comp_matchings(const std::string file_name, bool trusted, bool & canonical, size_t threads) {
+		input_view view;
+		open_view(file_name, view);
+		//The versioned format starts with zero, which is never a compressed matching
+		llfi marker = INVALID;
+		if (view.size >= sizeof(marker))
+			std::memcpy(&marker, view.data, sizeof(marker));
 		result_set found_matchings;
-		while (true) {
-			llfi actual_matching;
-			input_file.read((char*)& actual_matching, sizeof(llfi));
+		if (marker == 0)
+			found_matchings = load_encoded_matchings(view, canonical, threads);
+		else {
+			canonical = false;
+			found_matchings = load_raw_matchings(view, trusted, threads);
+		}
+		close_view(view);
+		return found_matchings;
+	}
 
-			if (input_file.fail()) {
-				//file read failed - if it was not due to EOF, there was some error
-				if (input_file.eof())
-					break;
-				else
-					errors::input_error("Unexpected error while reading input file!");
-			}
+	result_set serializer::load_raw_matchings(const input_view & view, bool trusted, size_t threads) {
 #ifdef CHECK_INPUT
-			perfect_matching decompressed_matching = decompress(actual_matching);
-			FOR_VERTICES(vertex_id) {
-				if (decompressed_matching[vertex_id] == INVALID)
-					errors::input_error("Some matching is corrupted!");
+		if (view.size % sizeof(llfi) != 0)
+			errors::input_error("Some matching is corrupted!");
+#endif //CHECK_INPUT
+		llfi matchings_cnt = view.size / sizeof(llfi);
+		llfi chunks_cnt = (matchings_cnt + LOAD_CHUNK_MATCHINGS - 1) / LOAD_CHUNK_MATCHINGS;
+		const llfi * raw_matchings = (const llfi *)view.data;
+		auto valid_chunk = [&](llfi chunk_id) {
+#ifdef CHECK_INPUT
+			for (llfi matching_id = chunk_id * LOAD_CHUNK_MATCHINGS; matching_id < std::min((chunk_id + 1) * LOAD_CHUNK_MATCHINGS, matchings_cnt); matching_id++) {
+				if (!is_compressed_matching(raw_matchings[matching_id]))
+					return false;
 			}
+#else
+			(void)chunk_id;
+#endif //CHECK_INPUT
+			return true;
+		};
+
+		//The unique matchings are only copied
+		if (trusted) {
+			result_set found_matchings;
+			std::vector<llfi> trusted_matchings(matchings_cnt);
+			run_chunks(chunks_cnt, threads, [&](llfi chunk_id) {
+				if (!valid_chunk(chunk_id))
+					return false;
+				std::copy(raw_matchings + chunk_id * LOAD_CHUNK_MATCHINGS, raw_matchings + std::min((chunk_id + 1) * LOAD_CHUNK_MATCHINGS, matchings_cnt), trusted_matchings.begin() + chunk_id * LOAD_CHUNK_MATCHINGS);
+				return true;
+			});
+			found_matchings.assign_flat(std::move(trusted_matchings));
+			return found_matchings;
+		}
+
+		return load_chunks(chunks_cnt, threads, [&](llfi chunk_id, result_set_builder & builder) {
+			if (!valid_chunk(chunk_id))
+				return false;
+			builder.add(chunk_id, raw_matchings + chunk_id * LOAD_CHUNK_MATCHINGS, raw_matchings + std::min((chunk_id + 1) * LOAD_CHUNK_MATCHINGS, matchings_cnt));
+			return true;
+		});
+	}
+
+	result_set serializer::load_encoded_matchings(const input_view & view, bool & canonical, size_t threads) {
+		//Header - zero, version, dimension, number of edges from Q_n, flags, number of matchings, number of blocks and checksum
+		if (view.size < COMP_HEADER_SIZE)
+			errors::input_error("The header of the matchings is corrupted!");
+		const char * position = view.data + sizeof(llfi);
+		sfi version, dimension, hyper_edges, flags;
+		llfi matchings_cnt, blocks_cnt, checksum;
+		read_field(position, version);
+		read_field(position, dimension);
+		read_field(position, hyper_edges);
+		read_field(position, flags);
+		read_field(position, matchings_cnt);
+		read_field(position, blocks_cnt);
+		read_field(position, checksum);
+		if (version != COMP_FORMAT_VERSION)
+			errors::input_error("Unsupported version of the format of matchings: " + std::to_string(version));
+		if (dimension != DIMENSION || hyper_edges != HYPER_EDGE_CNT)
+			errors::input_error("The matchings were saved for dimension " + std::to_string(dimension) + " with " + std::to_string(hyper_edges) + " edges from the hypercube!");
+		if (blocks_cnt != (matchings_cnt + COMP_BLOCK_MATCHINGS - 1) / COMP_BLOCK_MATCHINGS || blocks_cnt > (view.size - COMP_HEADER_SIZE) / (2 * sizeof(llfi)))
+			errors::input_error("The header of the matchings is corrupted!");
+		canonical = (flags & COMP_FLAG_CANONICAL) != 0;
+
+		//Index - the first matching and the offset of the deltas of every block
+		const char * index = view.data + COMP_HEADER_SIZE;
+		const char * deltas = index + blocks_cnt * 2 * sizeof(llfi);
+		llfi deltas_size = view.data + view.size - deltas;
+		auto block_entry = [&](llfi block_id, llfi & first_matching, llfi & offset) {
+			std::memcpy(&first_matching, index + block_id * 2 * sizeof(llfi), sizeof(llfi));
+			std::memcpy(&offset, index + block_id * 2 * sizeof(llfi) + sizeof(llfi), sizeof(llfi));
+		};
+
+		//Decodes given block into the output and adds the matchings to the checksum, returns false if it is corrupted
+		auto decode_block = [&](llfi block_id, llfi * output, llfi & block_checksum) {
+			llfi actual, offset, next_first = 0, end = deltas_size;
+			block_entry(block_id, actual, offset);
+			if (block_id + 1 < blocks_cnt)
+				block_entry(block_id + 1, next_first, end);
+			if (offset > end || end > deltas_size)
+				return false;
+			llfi block_matchings = std::min(COMP_BLOCK_MATCHINGS, matchings_cnt - block_id * COMP_BLOCK_MATCHINGS);
+			//The matchings are strictly increasing, thus every delta is positive
+			const unsigned char * byte = (const unsigned char *)deltas + offset;
+			const unsigned char * last_byte = (const unsigned char *)deltas + end;
+			for (llfi matching_id = 0; matching_id < block_matchings; matching_id++) {
+				if (matching_id > 0) {
+					llfi delta = 0;
+					sfi shift = 0;
+					do {
+						if (byte == last_byte || shift > 63)
+							return false;
+						delta |= (llfi)(*byte & 0x7F) << shift;
+						shift += 7;
+					} while (*(byte++) & 0x80);
+					if (delta == 0 || actual + delta < actual)
+						return false;
+					actual += delta;
+				}
+#ifdef CHECK_INPUT
+				if (!is_compressed_matching(actual))
+					return false;
 #endif //CHECK_INPUT
+				output[matching_id] = actual;
+				block_checksum += mix_hash(actual);
+			}
+			return byte == last_byte && (block_id + 1 == blocks_cnt || next_first > actual);
+		};
+
+		//Every task decodes several whole blocks
+		llfi chunk_blocks = std::max<llfi>(1, LOAD_CHUNK_MATCHINGS / COMP_BLOCK_MATCHINGS);
+		llfi chunks_cnt = (blocks_cnt + chunk_blocks - 1) / chunk_blocks;
+		std::atomic<llfi> decoded_checksum(0);
+		result_set found_matchings;
+		if (flags & COMP_FLAG_UNIQUE) {
+			//The matchings are sorted and unique (checked by the decoding), thus they are decoded right into the flat container
+			std::vector<llfi> sorted(matchings_cnt);
+			run_chunks(chunks_cnt, threads, [&](llfi chunk_id) {
+				llfi chunk_checksum = 0;
+				for (llfi block_id = chunk_id * chunk_blocks; block_id < std::min((chunk_id + 1) * chunk_blocks, blocks_cnt); block_id++) {
+					if (!decode_block(block_id, sorted.data() + block_id * COMP_BLOCK_MATCHINGS, chunk_checksum))
+						return false;
+				}
+				decoded_checksum += chunk_checksum;
+				return true;
+			});
+			found_matchings.assign_flat(std::move(sorted));
+		}
+		else {
+			found_matchings = load_chunks(chunks_cnt, threads, [&](llfi chunk_id, result_set_builder & builder) {
+				std::vector<llfi> decoded(chunk_blocks * COMP_BLOCK_MATCHINGS);
+				llfi * output = decoded.data();
+				llfi chunk_checksum = 0;
+				for (llfi block_id = chunk_id * chunk_blocks; block_id < std::min((chunk_id + 1) * chunk_blocks, blocks_cnt); block_id++) {
+					if (!decode_block(block_id, output, chunk_checksum))
+						return false;
+					output += std::min(COMP_BLOCK_MATCHINGS, matchings_cnt - block_id * COMP_BLOCK_MATCHINGS);
+				}
+				decoded_checksum += chunk_checksum;
+				builder.add(chunk_id, decoded.data(), output);
+				return true;
+			});
+		}
+		if (decoded_checksum != checksum)
+			errors::input_error("The checksum of the matchings does not match!");
+		return found_matchings;
+	}
 
-			found_matchings.insert(actual_matching);
+	void serializer::open_view(const std::string & file_name, input_view & view) {
+#ifdef __linux__
+		//tries to open and map selected file
+		view.descriptor = open(file_name.c_str(), O_RDONLY);
+		struct stat file_stat;
+		if (view.descriptor == -1 || fstat(view.descriptor, &file_stat) == -1)
+			errors::input_error("An error occured when opening " + file_name);
+		view.size = file_stat.st_size;
+		view.data = nullptr;
+		if (view.size > 0) {
+			void * mapped = mmap(nullptr, view.size, PROT_READ, MAP_PRIVATE, view.descriptor, 0);
+			if (mapped == MAP_FAILED)
+				errors::input_error("An error occured when mapping " + file_name);
+			madvise(mapped, view.size, MADV_WILLNEED);
+			view.data = (const char *)mapped;
 		}
+#else
+		//tries to open selected file and read it whole
+		input_file.open(file_name, std::ios::in | std::ios::binary | std::ios::ate);
+		if (input_file.fail())
+			errors::input_error("An error occured when opening " + file_name);
+		view.size = input_file.tellg();
+		view.buffer.resize(view.size);
+		input_file.seekg(0);
+		input_file.read(view.buffer.data(), view.size);
+		if (input_file.fail())
+			errors::input_error("Unexpected error while reading input file!");
 		input_file.close();
-		return std::move(found_matchings);
+		view.data = view.buffer.data();
+#endif //__linux__
+	}
+
+	void serializer::close_view(input_view & view) {
+#ifdef __linux__
+		if (view.data != nullptr)
+			munmap((void *)view.data, view.size);
+		close(view.descriptor);
+#else
+		std::vector<char>().swap(view.buffer);
+#endif //__linux__
+		view.data = nullptr;
+		view.size = 0;
 	}
 
 	void serializer::save_matchings(const std::string file_name, const result_set & matchings) {
@@ -66,7 +271,7 @@ namespace cube {
 		if (output_file.fail())
 			errors::output_error("An error occured when opening " + file_name);
 		//save the matching in non-comprimed state (may create HUGE files for DIMENSION=5)
-		for (llfi block_id = 0; block_id < PRIME_MOD; block_id++) {
+		for (llfi block_id = 0; block_id < matchings.block_count(); block_id++) {
 			for (auto it = matchings[block_id].begin(); it != matchings[block_id].end(); it++) {
 				output_file << get_serialized_matching(decompress(*it)) << std::endl;
 			}
@@ -76,135 +281,291 @@ namespace cube {
 		output_file.close();
 	}
 
-	void serializer::save_comp_matchings(const std::string file_name, const result_set & matchings) {
+	void serializer::save_comp_matchings(const std::string file_name, const result_set & matchings, bool canonical) {
 		//tries to open selected file
 		output_comp_file.open(file_name, std::ios::out | std::ios::binary);
 		if (output_comp_file.fail())
 			errors::output_error("An error occured when opening " + file_name);
-		//save the matching in comprimed state (still creates almost 10GB file for d=5)
-		for (llfi block_id = 0; block_id < PRIME_MOD; block_id++) {
+
+		//The matchings are sorted, thus the canonical ones (sharing long prefixes) have small deltas
+		std::vector<llfi> sorted;
+		sorted.reserve(matchings.size());
+		for (llfi block_id = 0; block_id < matchings.block_count(); block_id++) {
 			for (auto it = matchings[block_id].begin(); it != matchings[block_id].end(); it++) {
-				output_comp_file.write((char*)&(*it), sizeof(*it));
+				sorted.push_back(*it);
+			}
+		}
+		std::sort(sorted.begin(), sorted.end());
+		//The trusted input (-f) is not checked for duplicates, but the saved file is flagged as unique (a zero delta is refused by the loader)
+		sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+		llfi checksum = 0;
+		std::vector<llfi> index;
+		std::vector<unsigned char> deltas;
+		for (llfi matching_id = 0; matching_id < sorted.size(); matching_id++) {
+			checksum += mix_hash(sorted[matching_id]);
+			if (matching_id % COMP_BLOCK_MATCHINGS == 0) {
+				index.push_back(sorted[matching_id]);
+				index.push_back(deltas.size());
+			}
+			else {
+				//Little-endian groups of 7 bits, the highest bit marks that another group follows
+				llfi delta = sorted[matching_id] - sorted[matching_id - 1];
+				while (delta >= 0x80) {
+					deltas.push_back((unsigned char)(delta | 0x80));
+					delta >>= 7;
+				}
+				deltas.push_back((unsigned char)delta);
 			}
 		}
+
+		llfi marker = 0;
+		sfi version = COMP_FORMAT_VERSION, dimension = DIMENSION, hyper_edges = HYPER_EDGE_CNT, flags = COMP_FLAG_UNIQUE | (canonical ? COMP_FLAG_CANONICAL : 0);
+		llfi matchings_cnt = sorted.size(), blocks_cnt = index.size() / 2;
+		output_comp_file.write((char*)&marker, sizeof(marker));
+		output_comp_file.write((char*)&version, sizeof(version));
+		output_comp_file.write((char*)&dimension, sizeof(dimension));
+		output_comp_file.write((char*)&hyper_edges, sizeof(hyper_edges));
+		output_comp_file.write((char*)&flags, sizeof(flags));
+		output_comp_file.write((char*)&matchings_cnt, sizeof(matchings_cnt));
+		output_comp_file.write((char*)&blocks_cnt, sizeof(blocks_cnt));
+		output_comp_file.write((char*)&checksum, sizeof(checksum));
+		output_comp_file.write((char*)index.data(), index.size() * sizeof(llfi));
+		output_comp_file.write((char*)deltas.data(), deltas.size());
 		if (output_comp_file.fail())
 			errors::output_error("An error occured while saving compressed matchings!");
 		output_comp_file.close();
 	}
 
 
-	void serializer::save_paths(const std::string file_name, const std::vector<path> & paths) {
+	void serializer::open_paths(const std::string file_name) {
 		//tries to open selected file
-		output_path_file.open(file_name);
+		output_path_file.open(file_name, std::ios::out | std::ios::binary);
 		if (output_path_file.fail())
 			errors::output_error("An error occured when opening " + file_name);
+		sfi dimension = DIMENSION;
+		output_path_file.write((char*)&dimension, sizeof(dimension));
+	}
+
+	void serializer::save_matching_paths(const std::vector<path> & paths) {
+		perfect_matching matching = paths[0].base_matching;
+		llfi compressed_matching = compress(matching);
+		llfi paths_cnt = paths.size();
+		path_buffer.clear();
+		path_buffer.insert(path_buffer.end(), (char*)&compressed_matching, (char*)&compressed_matching + sizeof(compressed_matching));
+		path_buffer.insert(path_buffer.end(), (char*)&paths_cnt, (char*)&paths_cnt + sizeof(paths_cnt));
 		for (size_t path_id = 0; path_id != paths.size(); path_id++) {
-			if (path_id % ((VERTICES >> 1) * ((VERTICES >> 1) - 1)) == 0)
-				output_path_file << "Matching " << get_serialized_matching(paths[path_id].base_matching) << std::endl;
-			output_path_file << "\t" << get_serialized_path(paths[path_id]) << std::endl;
+			encode_path(paths[path_id]);
 		}
+		output_path_file.write(path_buffer.data(), path_buffer.size());
 		if (output_path_file.fail())
-			errors::output_error("An error occured while saving matchings!");
+			errors::output_error("An error occured while saving paths!");
+	}
+
+	void serializer::close_paths() {
+		output_path_file.close();
+		if (output_path_file.fail())
+			errors::output_error("An error occured while saving paths!");
+	}
+
+	void serializer::render_paths(const std::string input_name, const std::string output_name) {
+		//tries to open selected files
+		input_file.open(input_name, std::ios::in | std::ios::binary);
+		if (input_file.fail())
+			errors::input_error("An error occured when opening " + input_name);
+		output_path_file.open(output_name, std::ios::out);
+		if (output_path_file.fail())
+			errors::output_error("An error occured when opening " + output_name);
+
+		sfi dimension;
+		input_file.read((char*)&dimension, sizeof(dimension));
+		if (input_file.fail() || dimension != DIMENSION)
+			errors::input_error("The paths are not of the compiled dimension!");
+		while (true) {
+			llfi compressed_matching, paths_cnt;
+			input_file.read((char*)&compressed_matching, sizeof(compressed_matching));
+			if (input_file.fail()) {
+				//file read failed - if it was not due to EOF, there was some error
+				if (input_file.eof() && input_file.gcount() == 0)
+					break;
+				else
+					errors::input_error("Unexpected error while reading input file!");
+			}
+			input_file.read((char*)&paths_cnt, sizeof(paths_cnt));
+			if (input_file.fail() || paths_cnt > BIPARTITE_PAIRS_CNT)
+				errors::input_error("Some matching is corrupted!");
+			path actual_path(decompress(compressed_matching), 0, 0);
+#ifdef CHECK_INPUT
+			FOR_VERTICES(vertex_id) {
+				if (actual_path.base_matching[vertex_id] == INVALID)
+					errors::input_error("Some matching is corrupted!");
+			}
+#endif //CHECK_INPUT
+
+			output_path_file << "Matching " << get_serialized_matching(actual_path.base_matching) << "\n";
+			for (llfi path_id = 0; path_id < paths_cnt; path_id++) {
+				if (!decode_path(actual_path))
+					errors::input_error("Some path is corrupted!");
+				output_path_file << "\t" << get_serialized_path(actual_path) << "\n";
+			}
+		}
+		input_file.close();
 		output_path_file.close();
+		if (output_path_file.fail())
+			errors::output_error("An error occured while rendering paths!");
 	}
 
-	perfect_matching serializer::parse_matching(std::string & line) {
-		perfect_matching matching;
+	void serializer::encode_path(const path & this_path) {
+		path_buffer.push_back((char)(this_path.start_vertex | (this_path.has_solution ? 0x80 : 0)));
+		path_buffer.push_back((char)this_path.end_vertex);
+		if (!this_path.has_solution)
+			return;
 
+		//Dimensions of the edges from Q_n in the order of the path, packed from the lowest bits
+		size_t first_byte = path_buffer.size();
+		path_buffer.resize(first_byte + PATH_STEP_BYTES, 0);
+		size_t bit = 0;
+		sfi act_vertex = this_path.start_vertex;
+		for (sfi step = 0; step < PATH_STEPS; step++) {
+			act_vertex = this_path.base_matching[act_vertex];
+			sfi next_vertex = this_path.found_path[act_vertex];
+			sfi step_dimension = 0;
+			while ((1 << step_dimension) != (act_vertex ^ next_vertex))
+				step_dimension++;
+			for (sfi step_bit = 0; step_bit < PATH_STEP_BITS; step_bit++, bit++) {
+				if ((step_dimension >> step_bit) & 1)
+					path_buffer[first_byte + (bit >> 3)] |= (char)(1 << (bit & 7));
+			}
+			act_vertex = next_vertex;
+		}
+	}
+
+	bool serializer::decode_path(path & this_path) {
+		unsigned char ends[2];
+		input_file.read((char*)ends, sizeof(ends));
+		this_path.start_vertex = ends[0] & 0x7F;
+		this_path.end_vertex = ends[1];
+		this_path.has_solution = (ends[0] & 0x80) != 0;
+		if (input_file.fail() || this_path.start_vertex >= VERTICES || this_path.end_vertex >= VERTICES)
+			return false;
+		if (!this_path.has_solution)
+			return true;
+
+		unsigned char steps[PATH_STEP_BYTES];
+		input_file.read((char*)steps, sizeof(steps));
+		if (input_file.fail())
+			return false;
+		vertices_states visited;
+		visited.fill(false);
+		visited[this_path.start_vertex] = true;
+		size_t bit = 0;
+		sfi act_vertex = this_path.start_vertex;
+		for (sfi step = 0; step < PATH_STEPS; step++) {
+			act_vertex = this_path.base_matching[act_vertex];
+			sfi step_dimension = 0;
+			for (sfi step_bit = 0; step_bit < PATH_STEP_BITS; step_bit++, bit++) {
+				step_dimension |= ((steps[bit >> 3] >> (bit & 7)) & 1) << step_bit;
+			}
+			if (step_dimension >= DIMENSION)
+				return false;
+			sfi next_vertex = act_vertex ^ (1 << step_dimension);
+			//Every vertex is visited once
+			if (visited[act_vertex] || visited[next_vertex] || act_vertex == next_vertex)
+				return false;
+			visited[act_vertex] = visited[next_vertex] = true;
+			this_path.found_path[act_vertex] = next_vertex;
+			this_path.found_path[next_vertex] = act_vertex;
+			act_vertex = next_vertex;
+		}
+		//The path ends by the edge of the matching to the ending vertex, which closes the cycle
+		if (this_path.base_matching[act_vertex] != this_path.end_vertex || visited[this_path.end_vertex])
+			return false;
+		this_path.found_path[this_path.end_vertex] = this_path.start_vertex;
+		this_path.found_path[this_path.start_vertex] = this_path.end_vertex;
+		return true;
+	}
+
+	const char * serializer::line_start(const input_view & view, llfi offset) {
+		if (offset == 0 || offset >= view.size)
+			return view.data + std::min(offset, view.size);
+		//The line starts after the first end of line at offset - 1 or later
+		const char * line_end = (const char *)std::memchr(view.data + offset - 1, '\n', view.size - offset + 1);
+		return (line_end == nullptr) ? view.data + view.size : line_end + 1;
+	}
+
+	bool serializer::parse_matching(const char * position, const char * last, perfect_matching & matching, std::string & error) {
 #ifdef CHECK_INPUT 
 		sfi edge_count = 0;
-		FOR_VERTICES(vertex_id) {
-			matching[vertex_id] = INVALID;
-		}
+		matching.fill(INVALID);
 #endif //CHECK_INPUT
 
-		std::stringstream str(std::move(line));
-		std::string token;
 		while (true) {
-			str >> token;
-			if (token == "" || str.fail()) //end of line
+			while (position != last && is_space(*position))
+				position++;
+			if (position == last) //end of line
 				break;
+			const char * token = position;
+			while (position != last && !is_space(*position))
+				position++;
 
-			edge next_edge = parse_edge(std::move(token));
+			edge next_edge;
+			if (!parse_edge(token, position, next_edge, error))
+				return false;
 			matching[next_edge.first] = next_edge.second;
 			matching[next_edge.second] = next_edge.first;
 
 #ifdef CHECK_INPUT 
-			if (edge_count == MATCH_SIZE)
-				errors::input_error("Some line has too many edges!");
+			if (edge_count == MATCH_SIZE) {
+				error = "Some line has too many edges!";
+				return false;
+			}
 			edge_count++;
 #endif //CHECK_INPUT
-		}		
+		}
 #ifdef CHECK_INPUT 
 		//Check, if the result is really a matching
-		if (edge_count != MATCH_SIZE)
-			errors::input_error("Some line does not have enough edges!");
+		if (edge_count != MATCH_SIZE) {
+			error = "Some line does not have enough edges!";
+			return false;
+		}
 		FOR_VERTICES(vertex_id) {
-			if (matching[vertex_id] == INVALID)
-				errors::input_error("Some vertex was not set up!");
+			if (matching[vertex_id] == INVALID) {
+				error = "Some vertex was not set up!";
+				return false;
+			}
 		}
-#endif //CHECK_INPUT_
-		return std::move(matching);
-	}
-
-	void serializer::next_line(std::string & line) {
-		do {
-			std::getline(input_file, line);
-		} while (line.empty() && !input_file.fail());	//skipping empty lines
+#endif //CHECK_INPUT
+		return true;
 	}
 
-	edge serializer::parse_edge(std::string && token) {
-		sfi vert1, vert2;
-		try {
-			vert1 = std::stoi(token);
-			size_t vert2_start = std::find(token.cbegin(), token.cend(), '>') - token.cbegin() + 1;
-			vert2 = std::stoi(token.substr(vert2_start, token.length() - vert2_start));
+	bool serializer::parse_edge(const char * first, const char * last, edge & parsed, std::string & error) {
+		//Syntax v(x)->v(y) checked in the single pass (numbers larger than any vertex are saturated)
+		const char * position = first;
+		if (position == last || *position < '0' || *position > '9') {
+			error = "An error occured while parsing edges!";
+			return false;
+		}
+		size_t vert1 = 0, vert2 = 0;
+		while (position != last && *position >= '0' && *position <= '9')
+			vert1 = std::min<size_t>(vert1 * 10 + (*(position++) - '0'), VERTICES);
+		bool well_formed = (last - position > 2 && position[0] == '-' && position[1] == '>');
+		if (well_formed) {
+			position += 2;
+			while (position != last && *position >= '0' && *position <= '9')
+				vert2 = std::min<size_t>(vert2 * 10 + (*(position++) - '0'), VERTICES);
+			well_formed = (position == last);
 		}
-		catch (...) {
-			errors::input_error("An error occured while parsing edges!");
+		if (!well_formed) {
+			error = "Wrong edge definition: " + std::string(first, last);
+			return false;
 		}
-		//syntax check
 #ifdef CHECK_INPUT 
-		if (vert1 >= VERTICES || vert2 >= VERTICES)
-			errors::input_error("Nonexisting vertex selected: " + token);
-		sfi position = 0;
-		sfi mode = 0;
-		bool was_number = false;
-		while (position < token.length()) {
-			switch (mode) {
-			case 0:
-				if (token[position] < '0' || token[position] > '9') {
-					if (!was_number || token[position] != '-')
-						errors::input_error("Wrong edge definition: " + token);
-					else {
-						mode++;
-						was_number = false;
-					}
-				}
-				else
-					was_number = true;
-				break;
-			case 1:
-				if (token[position] != '>')
-					errors::input_error("Wrong edge definition: " + token);
-				else
-					mode++;
-				break;
-			case 2:
-				if (token[position] < '0' || token[position] > '9')
-					errors::input_error("Wrong edge definition: " + token);
-				was_number = true;
-				break;
-			default:
-				errors::assert_error("Reached default case in a switch!");
-				break;
-			}
-			position++;
+		if (vert1 >= VERTICES || vert2 >= VERTICES) {
+			error = "Nonexisting vertex selected: " + std::string(first, last);
+			return false;
 		}
-		if (mode != 2 || !was_number)
-			errors::input_error("Wrong edge definition: " + token);
-#endif //CHECK_INPUT_			
-		return std::make_pair(vert1, vert2);
+#endif //CHECK_INPUT
+		parsed = std::make_pair((sfi)vert1, (sfi)vert2);
+		return true;
 	}
 
 	std::string serializer::get_serialized_matching(const perfect_matching & matching) {
@@ -242,4 +603,5 @@ namespace cube {
 	std::ofstream serializer::output_file;
 	std::ofstream serializer::output_comp_file;
 	std::ofstream serializer::output_path_file;
+	std::vector<char> serializer::path_buffer;
 }
\ No newline at end of file
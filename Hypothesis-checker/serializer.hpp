@@ -5,37 +5,158 @@
 #include "errors.hpp"
 #include "path.hpp"
 #include "matchings.hpp"
+#include "containers.hpp"
+#include "scheduler.hpp"
 #include <string>
 #include <vector>
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 namespace cube {
 	/* Serializes/deserializes matchings and paths to/from files */
 	class serializer {
 	public:
-		//Loads matchings from selected file
-		static result_set load_matchings(const std::string file_name);
+		//Loads matchings from selected file, trusted matchings (known to be unique) are only stored into a flat container.
+		//On linux the file is mapped into memory, its chunks of lines are parsed by given number of threads.
+		static result_set load_matchings(const std::string file_name, bool trusted = false, size_t threads = default_thread_count());
 
-		//Loads matchings from selected file
-		static result_set load_comp_matchings(const std::string file_name);
+		//Loads compressed matchings from selected file (both the versioned format and the raw dump of older versions), canonical is set to whether they were saved as canonical.
+		//On linux the file is mapped into memory, its chunks are decoded, validated and inserted by given number of threads. The unique matchings (by the header or trusted raw dumps)
+		//are decoded into a flat container without any hashing.
+		static result_set load_comp_matchings(const std::string file_name, bool trusted, bool & canonical, size_t threads = default_thread_count());
 
 		//Saves matchings to selected file
 		static void save_matchings(const std::string file_name, const result_set & matchings);
 
-		//Saves matchings to selected file
-		static void save_comp_matchings(const std::string file_name, const result_set & matchings);
+		//Saves matchings to selected file in the versioned format - a header with the settings, flags (canonical if the matchings are lexicographically minimal) and checksum,
+		//the index of blocks and sorted matchings delta-encoded within blocks of COMP_BLOCK_MATCHINGS
+		static void save_comp_matchings(const std::string file_name, const result_set & matchings, bool canonical);
+
+		//Opens selected binary file for paths saved by save_matching_paths
+		static void open_paths(const std::string file_name);
+
+		//Saves paths of all pairs of ending vertices of a matching to the opened binary file - the compressed matching, the number of paths and the records of paths
+		//(the starting vertex with the flag of a solution in the highest bit, the ending vertex and the packed dimensions of the edges from Q_n for a solved pair)
+		static void save_matching_paths(const std::vector<path> & paths);
 
-		//Saves paths to selected file
-		static void save_paths(const std::string file_name, const std::vector<path> & paths);
+		//Closes the file of paths
+		static void close_paths();
+
+		//Renders the binary file of paths into the text form (the matching and a line p(1)->p(2)->...->p(n) for every pair)
+		static void render_paths(const std::string input_name, const std::string output_name);
 		
-	private:		
-		//Deserializes perfect matchings from format v(1)->v(2) v(3)->v(4) ... v(n-1)->v(n)
-		static perfect_matching parse_matching(std::string & line);
+	private:
+		/* Contents of an input file - mapped into memory on linux, otherwise read into a buffer. */
+		struct input_view {
+			const char * data;
+			llfi size;
+#ifdef __linux__
+			int descriptor;
+#else
+			std::vector<char> buffer;
+#endif //__linux__
+		};
+
+		//Version of the format of compressed matchings
+		static const sfi COMP_FORMAT_VERSION = 2;
+
+		//Flags of the format of compressed matchings - lexicographically minimal matchings, no duplicities
+		static const sfi COMP_FLAG_CANONICAL = 1;
+		static const sfi COMP_FLAG_UNIQUE = 2;
+
+		//Size of the header of compressed matchings
+		static const llfi COMP_HEADER_SIZE = 4 * sizeof(llfi) + 4 * sizeof(sfi);
+
+		/* Matchings parsed from a chunk of lines of a text file. */
+		struct text_chunk {
+			text_chunk() : lines(0) {}
+
+			//Compressed matchings
+			std::vector<llfi> matchings;
+
+			//Number of lines parsed (including the wrong one)
+			llfi lines;
+
+			//The first error of the chunk (empty if there is none)
+			std::string error;
+		};
+
+		//Returns the start of the first line starting at offset or later (or the end of the file)
+		static const char * line_start(const input_view & view, llfi offset);
 
-		//Transforms text-based edge (v(x)->v(y)) into structure edge.
-		static edge parse_edge(std::string && token);
+		//Opens and maps (or reads) selected file
+		static void open_view(const std::string & file_name, input_view & view);
+
+		//Releases the file
+		static void close_view(input_view & view);
+
+		//Loads the raw dump of compressed matchings of older versions
+		static result_set load_raw_matchings(const input_view & view, bool trusted, size_t threads);
+
+		//Loads compressed matchings in the versioned format
+		static result_set load_encoded_matchings(const input_view & view, bool & canonical, size_t threads);
+
+		//Runs load_chunk(chunk_id) for all chunks by given number of threads, load_chunk returns false if the chunk is corrupted
+		template<class chunk_loader>
+		static void run_chunks(llfi chunks_cnt, size_t threads, chunk_loader load_chunk) {
+			std::atomic<bool> corrupted(false);
+			task_scheduler<llfi> chunk_scheduler(threads);
+			for (llfi chunk_id = 0; chunk_id < chunks_cnt; chunk_id++) {
+				chunk_scheduler.push(llfi(chunk_id));
+			}
+			chunk_scheduler.run([&](size_t /*worker_id*/, llfi chunk_id) {
+				if (!load_chunk(chunk_id))
+					corrupted = true;
+			});
+			if (corrupted)
+				errors::input_error("Some matching is corrupted!");
+		}
+
+		//Runs load_chunk(chunk_id, builder) for all chunks by given number of threads and then builds the set from the values added to the builder, load_chunk returns false if the chunk is corrupted
+		template<class chunk_loader>
+		static result_set load_chunks(llfi chunks_cnt, size_t threads, chunk_loader load_chunk) {
+			result_set_builder builder(chunks_cnt);
+			run_chunks(chunks_cnt, threads, [&](llfi chunk_id) {
+				return load_chunk(chunk_id, builder);
+			});
+
+			task_scheduler<llfi> block_scheduler(threads);
+			for (llfi block_id = 0; block_id < result_set::BLOCKS_CNT; block_id++) {
+				block_scheduler.push(llfi(block_id));
+			}
+			block_scheduler.run([&](size_t /*worker_id*/, llfi block_id) {
+				builder.build(block_id);
+			});
+			return builder.release();
+		}
+
+		//Reads a field of the header and moves the position after it
+		template<class field>
+		static void read_field(const char * & position, field & value) {
+			std::memcpy(&value, position, sizeof(value));
+			position += sizeof(value);
+		}
+
+		//Deserializes perfect matching from the line [position, last) in format v(1)->v(2) v(3)->v(4) ... v(n-1)->v(n) in a single pass without any allocation, returns false and sets error if it is wrong
+		static bool parse_matching(const char * position, const char * last, perfect_matching & matching, std::string & error);
+
+		//Transforms text-based edge [first, last) (v(x)->v(y)) into structure edge, returns false and sets error if it is wrong
+		static bool parse_edge(const char * first, const char * last, edge & parsed, std::string & error);
+
+		//Returns whether the character separates edges
+		static bool is_space(char character) {
+			return character == ' ' || character == '\t' || character == '\r' || character == '\v' || character == '\f';
+		}
 
 		//Transforms perfect matching into u_1->v_1 u_2->v_2 ... u_k->v_k
 		static std::string get_serialized_matching(const perfect_matching & matching);
@@ -43,8 +164,12 @@ namespace cube {
 		//Serializes given path into p(1)->p(2)->...->p(n)
 		static std::string get_serialized_path(const path & path_);
 		
-		//Loads next non-empty line into buffer
-		static void next_line(std::string & line);
+		//Appends the record of given path to the buffer of paths
+		static void encode_path(const path & path_);
+
+		//Reads the record of a path of given matching from the input file, returns false if it is corrupted
+		static bool decode_path(path & path_);
+
 
 
 		//input file stream
@@ -58,6 +183,9 @@ namespace cube {
 
 		//Path output file stream
 		static std::ofstream output_path_file;
+
+		//Records of paths of a matching written at once
+		static std::vector<char> path_buffer;
 	};
 }
 
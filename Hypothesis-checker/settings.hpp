@@ -30,6 +30,25 @@ namespace cube {
 	//Whether the input correctness should be checked - if the input is guaranted to be correct, disable would speed up loading, otherwise bad unchecked input could perform undefined behaviour.
 	#define CHECK_INPUT
 
+	//Whether vectorized (AVX2) kernels should be used for the comparison of transformed matchings in the canonicity check of the generator when the CPU supports them (only for dimension 5, otherwise scalar code is used)
+	#define USE_SIMD
+
+	//Whether the generator should produce every class of isomorphism exactly once (orderly generation), thus no set of visited partial matchings nor duplicity check of results is needed.
+	//Otherwise partial matchings up to 10 edges are remembered and results are deduplicated (may be used for cross-checking).
+	#define ORDERLY_GENERATION
+
+	//Whether the pathfinding solves only one pair of ending vertices from every orbit of the automorphism group of the matching, the paths for the other pairs are mapped from it.
+	#define SYMMETRY_REDUCTION
+
+	//Whether the pathfinding adds all forced edges (of vertices with single possibility) at once and stops the search immediately when some vertex has no possibility.
+	#define FORWARD_CHECKING
+
+	//Whether the last paths found for a matching are kept and tried for its other pairs of ending vertices (directly or after an exchange of two edges) before the search is run.
+	#define SOLUTION_POOL
+
+	//Number of the last found paths of a matching kept in the pool. Has an effect only with SOLUTION_POOL
+	static const sfi SOLUTION_POOL_SIZE = 32;
+
 	//Whether information about calculation should be written to std::cout periodicaly (as follows)
 	#define PROGRESS_INFO
 
@@ -39,6 +58,41 @@ namespace cube {
 	//Period of information about the count of solved matchings. Has an effect only with PROGRESS_INFO
 	static const llfi GENERATED_PATHS_INFO = 100;
 
+	//Number of edges of partial matchings at which the generator search tree is split into independent tasks for worker threads. Greater depth gives more (and smaller) tasks.
+	static const sfi GENERATOR_SPLIT_DEPTH = 5;
+
+	//Maximal number of matchings solved as one task of parallel pathfinding. The matchings are ordered by their estimated cost (the most expensive first), smaller tasks balance the load of threads better.
+	static const llfi PATHFINDING_TASK_MATCHINGS = 16;
+
+	//Number of consecutive matchings (in the order of sequential iteration) estimated, ordered by their estimated cost and solved together. Only the window in flight is held with its stabilizers and waiting outputs, thus it limits the memory of pathfinding.
+	static const llfi PATHFINDING_SCHEDULE_WINDOW = 1 << 16;
+
+	//The estimated cost of a task of parallel pathfinding is at most the total estimated cost of its window divided by the number of workers and this number (unless it has a single matching), thus the expensive matchings are not grouped together.
+	static const llfi PATHFINDING_TASKS_PER_WORKER = 32;
+
+	//Coefficients of the binary logarithm of the estimated number of nodes of the search of a matching - the base, per edge not from Q_n, per edge from Q_n in the dimension with most of them,
+	//the addition if all edges are parallel and per binary logarithm of the size of the stabilizer (used only with SYMMETRY_REDUCTION). They were fitted to the calibration log (-l) of dimension 5.
+	static const double COST_BASE = 9.11;
+	static const double COST_FREE_EDGE = 0.065;
+	static const double COST_LARGEST_DIMENSION = 0.048;
+	static const double COST_ALL_PARALLEL = 3.67;
+	static const double COST_STABILIZER = -0.545;
+
+	//Number of nodes of the search of a single matching after which its remaining pairs of ending vertices are split into tasks for idle workers (a straggler matching would keep one thread busy long after the others finished).
+	static const llfi STRAGGLER_NODES = 10000;
+
+	//Number of pairs of ending vertices of a straggler matching solved as one task.
+	static const llfi STRAGGLER_CHUNK_PAIRS = 4;
+
+	//Number of compressed matchings of the input file validated and inserted as one task of the parallel loading.
+	static const llfi LOAD_CHUNK_MATCHINGS = 1 << 20;
+
+	//Number of bytes of the text file of matchings parsed as one task of the parallel loading (the lines starting in the range).
+	static const llfi LOAD_CHUNK_BYTES = 1 << 24;
+
+	//Number of sorted matchings delta-encoded as one block of the file of compressed matchings (the blocks are indexed, thus they are decoded independently by several threads).
+	static const llfi COMP_BLOCK_MATCHINGS = 4096;
+
 	/*-------------------------------------------------*/
 	/* Dependent constants and complex data structures */
 	/*-------------------------------------------------*/
@@ -55,6 +109,15 @@ namespace cube {
 	//Number of distinct pairs of path endings
 	static const sfi BIPARTITE_PAIRS_CNT = MATCH_SIZE * (MATCH_SIZE - 1); 
 
+	//Number of edges from Q_n of a path between a pair of ending vertices (the other edges are from the matching)
+	static const sfi PATH_STEPS = MATCH_SIZE - 1;
+
+	//Number of bits of a dimension of an edge from Q_n in the binary file of paths
+	static const sfi PATH_STEP_BITS = DIMENSION > 4 ? 3 : (DIMENSION > 2 ? 2 : 1);
+
+	//Number of bytes of the packed dimensions of the edges of a path in the binary file of paths
+	static const sfi PATH_STEP_BYTES = (PATH_STEPS * PATH_STEP_BITS + 7) / 8;
+
 	//Global number to express invalid value (e. g. neighbour of unmatched vertices)
 	static const sfi INVALID = (sfi)(-1);
 
@@ -70,11 +133,17 @@ namespace cube {
 	//Boolean values for all vertices
 	typedef std::array<bool, VERTICES> vertices_states;
 	
+	//Bitboard with one bit for every vertex (dimension up to 6)
+	typedef llfi vertices_mask;
+
 	//Container for some value for every dimension 
 	typedef std::array<sfi, DIMENSION> dimension_array;
 
 	//Container for some state value for every dimension 
 	typedef std::array<bool, DIMENSION> dimension_states;
+
+	//Engines of the search for Hamiltonian paths (selected by the argument -s), all of them give the same results
+	enum class solver_type { SEARCH, BITBOARD };
 	
 	/*-----------------------------------*/
 	/* Other useful constants and macros */
@@ -96,6 +165,20 @@ namespace cube {
 		5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5
 	};
 
+	/* Returns the index of the lowest set bit of non-zero mask. */
+	inline sfi lowest_bit(vertices_mask mask) {
+#if defined(__GNUC__)
+		return (sfi)__builtin_ctzll(mask);
+#else
+		sfi index = 0;
+		while ((mask & 1) == 0) {
+			mask >>= 1;
+			index++;
+		}
+		return index;
+#endif //__GNUC__
+	}
+
 	//macros for synoptical iteration over often used arrays
 	#define FOR_VERTICES(var_name) for (sfi var_name = 0; var_name < VERTICES; var_name++)
 	#define FOR_DIMENSION(var_name) for (sfi var_name = 0; var_name < DIMENSION; var_name++)
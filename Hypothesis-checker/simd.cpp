@@ -0,0 +1,55 @@
+#include "simd.hpp"
+
+#if defined(USE_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_AVX2
+#include <immintrin.h>
+#endif
+
+namespace cube {
+#ifdef SIMD_AVX2
+	/* Returns table[indices[i]] for all 32 bytes, low and high contain the lower and upper half of the table in both lanes.
+	   vpshufb works only inside 128-bit lanes, thus both halves are shuffled and the result is selected by 4th bit of the index. Indices with 7th bit set give 0. */
+	__attribute__((target("avx2"))) static inline __m256i permute_bytes(const __m256i low, const __m256i high, const __m256i indices) {
+		__m256i from_low = _mm256_shuffle_epi8(low, indices);
+		__m256i from_high = _mm256_shuffle_epi8(high, indices);
+		return _mm256_blendv_epi8(from_low, from_high, _mm256_slli_epi16(indices, 3));
+	}
+
+	/* Returns matching (split into lanes) transformed by given automorphism, unused vertices stay INVALID. */
+	__attribute__((target("avx2"))) static inline __m256i transform_matching(const __m256i source_low, const __m256i source_high, const automorphism_id transform_id) {
+		__m256i transform = _mm256_loadu_si256((const __m256i *) automorphisms::forward(transform_id).data());
+		__m256i inverse_transform = _mm256_loadu_si256((const __m256i *) automorphisms::inverse(transform_id).data());
+
+		//neighbours[v] = matching[inverse_transform[v]]
+		__m256i neighbours = permute_bytes(source_low, source_high, inverse_transform);
+		//result[v] = transform[neighbours[v]]
+		__m256i unused = _mm256_cmpeq_epi8(neighbours, _mm256_set1_epi8((char)INVALID));
+		return _mm256_or_si256(permute_bytes(_mm256_permute2x128_si256(transform, transform, 0x00), _mm256_permute2x128_si256(transform, transform, 0x11), neighbours), unused);
+	}
+
+	__attribute__((target("avx2"))) sfi simd::first_difference(const perfect_matching & matching, const automorphism_id transform_id) {
+		__m256i source = _mm256_loadu_si256((const __m256i *) matching.data());
+		__m256i actual = transform_matching(_mm256_permute2x128_si256(source, source, 0x00), _mm256_permute2x128_si256(source, source, 0x11), transform_id);
+		unsigned different = ~(unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(actual, source));
+		if (different == 0)
+			return VERTICES;
+		return (sfi)__builtin_ctz(different);
+	}
+
+	bool simd::check_available() {
+		__builtin_cpu_init();
+		return VERTICES == 32 && sizeof(sfi) == 1 && __builtin_cpu_supports("avx2");
+	}
+#else
+	sfi simd::first_difference(const perfect_matching &, const automorphism_id) {
+		errors::unimplemented_feature("Vectorized kernels are not compiled!");
+		return VERTICES;
+	}
+
+	bool simd::check_available() {
+		return false;
+	}
+#endif //SIMD_AVX2
+
+	const bool simd::available = simd::check_available();
+}
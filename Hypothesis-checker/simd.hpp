@@ -0,0 +1,24 @@
+#ifndef SIMD_
+#define SIMD_
+
+#include "settings.hpp"
+#include "automorphisms.hpp"
+
+namespace cube {
+	/* Vectorized kernels for working with matchings as whole registers. Currently implemented for d=5 using AVX2 (a perfect matching is exactly 32 bytes),
+	   the CPU support is checked at runtime. Callers must use the scalar code if available is false. */
+	class simd {
+	public:
+		/* Returns the first vertex v for which the matching transformed by given automorphism differs from the matching itself (VERTICES if they are same). */
+		static sfi first_difference(const perfect_matching & matching, const automorphism_id transform_id);
+
+		//Whether the kernels may be used (they are compiled, the dimension fits and the CPU supports the instructions)
+		static const bool available;
+
+	private:
+		/* Checks whether the kernels may be used. */
+		static bool check_available();
+	};
+}
+
+#endif //SIMD_
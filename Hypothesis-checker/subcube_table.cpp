@@ -0,0 +1,135 @@
+#include "subcube_table.hpp"
+#include "pathfinding.hpp"
+#include "scheduler.hpp"
+
+namespace cube {
+	void subcube_table::generate(const std::string & file_name, size_t threads) {
+		if (DIMENSION > 4)
+			errors::unimplemented_feature("The table may be generated only for dimension at most 4!");
+		llfi matchings_cnt = matchings_count(VERTICES);
+		llfi width = MATCH_SIZE;
+		std::vector<path_code> rows(matchings_cnt * width * width, NO_PATH);
+
+		//Ranges of ranks are solved in parallel, every worker with its own solver context
+		const llfi TASK_SIZE = 1024;
+		task_scheduler<std::pair<llfi, llfi>> scheduler(threads);
+		for (llfi begin = 0; begin < matchings_cnt; begin += TASK_SIZE) {
+			scheduler.push(std::make_pair(begin, std::min(begin + TASK_SIZE, matchings_cnt)));
+		}
+		std::vector<pathfinding> contexts(scheduler.workers());
+		scheduler.run([&](size_t worker_id, const std::pair<llfi, llfi> & task) {
+			perfect_matching found_path;
+			for (llfi matching_rank = task.first; matching_rank < task.second; matching_rank++) {
+				perfect_matching matching = unrank(matching_rank);
+				contexts[worker_id].prepare_matching(matching);
+				FOR_VERTICES(even_vertex) {
+					if (hamming[even_vertex] & 1)
+						continue;
+					FOR_VERTICES(odd_vertex) {
+						if (!(hamming[odd_vertex] & 1) || matching[even_vertex] == odd_vertex)
+							continue;
+						if (!contexts[worker_id].has_path(matching, std::min(even_vertex, odd_vertex), std::max(even_vertex, odd_vertex), found_path))
+							continue;
+						//Encode the edges from Q_n in the order from even_vertex
+						path_code code = 0;
+						sfi actual_vertex = even_vertex;
+						for (sfi step_id = 0; step_id < MATCH_SIZE - 1; step_id++) {
+							actual_vertex = matching[actual_vertex];
+							code |= (path_code)(top_one[actual_vertex ^ found_path[actual_vertex]] << (step_id * SUBCUBE_STEP_BITS));
+							actual_vertex = found_path[actual_vertex];
+						}
+						rows[matching_rank * width * width + (even_vertex >> 1) * width + (odd_vertex >> 1)] = code;
+					}
+				}
+			}
+		});
+
+		std::ofstream output_file(file_name, std::ios::out | std::ios::binary);
+		if (output_file.fail())
+			errors::output_error("An error occured when opening " + file_name);
+		sfi dimension = DIMENSION;
+		llfi size = width * width;
+		output_file.write((char*)&dimension, sizeof(dimension));
+		output_file.write((char*)&matchings_cnt, sizeof(matchings_cnt));
+		output_file.write((char*)&size, sizeof(size));
+		output_file.write((char*)rows.data(), rows.size() * sizeof(path_code));
+		if (output_file.fail())
+			errors::output_error("An error occured while saving the table!");
+	}
+
+	void subcube_table::load(const std::string & file_name) {
+		std::ifstream input_file(file_name, std::ios::in | std::ios::binary);
+		if (input_file.fail())
+			errors::input_error("An error occured when opening " + file_name);
+		sfi dimension = 0;
+		llfi matchings_cnt = 0;
+		llfi size = 0;
+		llfi width = MATCH_SIZE >> 1;
+		input_file.read((char*)&dimension, sizeof(dimension));
+		input_file.read((char*)&matchings_cnt, sizeof(matchings_cnt));
+		input_file.read((char*)&size, sizeof(size));
+		if (input_file.fail() || dimension + 1 != DIMENSION || matchings_cnt != matchings_count(MATCH_SIZE) || size != width * width)
+			errors::input_error("The table in " + file_name + " is not a table of dimension " + std::to_string(DIMENSION - 1) + "!");
+		data.resize(matchings_cnt * size);
+		input_file.read((char*)data.data(), data.size() * sizeof(path_code));
+		if (input_file.fail())
+			errors::input_error("Unexpected error while reading the table!");
+		row_width = width;
+		row_size = size;
+	}
+
+	llfi subcube_table::rank(const sfi * matching, sfi vertices_cnt) {
+		sfi width = vertices_cnt >> 1;
+		llfi matching_rank = 0;
+		llfi unused = ((llfi)1 << width) - 1;
+		for (sfi index = 0; index < width; index++) {
+			//The even vertex of given index and the index of its partner among the remaining odd vertices
+			sfi even_vertex = (index << 1) | (hamming[index] & 1);
+			sfi partner = matching[even_vertex] >> 1;
+			sfi choice = 0;
+			for (llfi lower = unused & (((llfi)1 << partner) - 1); lower != 0; lower &= lower - 1) {
+				choice++;
+			}
+			matching_rank = matching_rank * (width - index) + choice;
+			unused &= ~((llfi)1 << partner);
+		}
+		return matching_rank;
+	}
+
+	perfect_matching subcube_table::unrank(llfi matching_rank) {
+		//Split the rank into the choices (the last choice has the radix 1)
+		std::array<sfi, MATCH_SIZE> choices;
+		for (sfi index = MATCH_SIZE; index > 0; index--) {
+			sfi radix = MATCH_SIZE - index + 1;
+			choices[index - 1] = matching_rank % radix;
+			matching_rank /= radix;
+		}
+		perfect_matching matching;
+		llfi unused = ((llfi)1 << MATCH_SIZE) - 1;
+		for (sfi index = 0; index < MATCH_SIZE; index++) {
+			llfi remaining = unused;
+			for (sfi skipped = 0; skipped < choices[index]; skipped++) {
+				remaining &= remaining - 1;
+			}
+			sfi partner = lowest_bit(remaining);
+			unused &= ~((llfi)1 << partner);
+			sfi even_vertex = (index << 1) | (hamming[index] & 1);
+			sfi odd_vertex = (partner << 1) | ((hamming[partner] & 1) ^ 1);
+			matching[even_vertex] = odd_vertex;
+			matching[odd_vertex] = even_vertex;
+		}
+		return matching;
+	}
+
+	llfi subcube_table::matchings_count(sfi vertices_cnt) {
+		llfi count = 1;
+		for (llfi radix = vertices_cnt >> 1; radix > 1; radix--) {
+			count *= radix;
+		}
+		return count;
+	}
+
+	std::vector<subcube_table::path_code> subcube_table::data;
+	llfi subcube_table::row_width = 0;
+	llfi subcube_table::row_size = 0;
+}
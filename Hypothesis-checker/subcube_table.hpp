@@ -0,0 +1,75 @@
+#ifndef SUBCUBE_TABLE_
+#define SUBCUBE_TABLE_
+
+#include "settings.hpp"
+#include "errors.hpp"
+#include <string>
+#include <vector>
+#include <fstream>
+
+namespace cube {
+	/* Table of Hamiltonian paths for all pairs of ending vertices of all perfect matchings in B(2^n) of a small hypercube. It is generated by the program compiled for dimension n-1
+	   and used by the program for dimension n to construct paths from the paths of both halves of Q_n (if no edge of the matching crosses between them).
+	   A matching of B(2^n) maps the even vertices onto the odd ones - every vertex v of a parity has the index v >> 1 among the vertices of its parity,
+	   thus the matching is a permutation of indices and it is ranked by its Lehmer code (the index of the partner of i-th even vertex among the remaining ones, radices V/2, V/2 - 1, ..., 1).
+	   The row of a matching stores the path of every pair of an even vertex u and an odd vertex v at position (u >> 1) * V/2 + (v >> 1). */
+	class subcube_table {
+	public:
+		//Encoded path - the dimensions of its edges from Q_n (SUBCUBE_STEP_BITS each) in the order from the even ending vertex, the edges of the matching are given by the matching
+		typedef uint16_t path_code;
+
+		//Code of a pair without any path
+		static const path_code NO_PATH = 0xFFFF;
+
+		//Number of bits of a dimension of an edge in path_code (dimension of the table is at most 4)
+		static const sfi SUBCUBE_STEP_BITS = 2;
+
+		/* Finds the paths for all pairs of ending vertices of all perfect matchings in B(2^n) (n is the dimension of this program, at most 4) using given number of threads and saves the table into the file. */
+		static void generate(const std::string & file_name, size_t threads);
+
+		/* Loads the table of dimension DIMENSION - 1 from the file. */
+		static void load(const std::string & file_name);
+
+		/* Returns whether the table is loaded. */
+		static bool is_loaded() {
+			return !data.empty();
+		}
+
+		/* Returns the rank of the perfect matching in B(2^n) of given number of vertices (matching[v] is the partner of v). */
+		static llfi rank(const sfi * matching, sfi vertices_cnt);
+
+		/* Returns the index of the vertex in its half of Q_n split along given dimension (the bit of the dimension is removed). */
+		static sfi half_index(sfi vertex_id, sfi dim) {
+			return ((vertex_id >> (dim + 1)) << dim) | (vertex_id & ((1 << dim) - 1));
+		}
+
+		/* Returns the code of the path of the loaded table for the matching of given rank and the pair of vertices of opposite parities (NO_PATH if there is none).
+		   The code describes the path from the even vertex of the pair. */
+		static path_code find_path(llfi matching_rank, sfi first_vertex, sfi second_vertex) {
+			if (hamming[first_vertex] & 1)
+				std::swap(first_vertex, second_vertex);
+			return data[matching_rank * row_size + (first_vertex >> 1) * row_width + (second_vertex >> 1)];
+		}
+
+		/* Returns the dimension of the edge from Q_n of given step of the encoded path. */
+		static sfi step_dimension(path_code code, sfi step_id) {
+			return (code >> (step_id * SUBCUBE_STEP_BITS)) & ((1 << SUBCUBE_STEP_BITS) - 1);
+		}
+
+	private:
+		/* Returns the matching of given rank for the vertices of Q_n. */
+		static perfect_matching unrank(llfi matching_rank);
+
+		/* Returns the number of perfect matchings in B(2^n) of given number of vertices. */
+		static llfi matchings_count(sfi vertices_cnt);
+
+		//Rows of all matchings
+		static std::vector<path_code> data;
+
+		//Number of vertices of a parity and number of pairs of a row
+		static llfi row_width;
+		static llfi row_size;
+	};
+}
+
+#endif //SUBCUBE_TABLE_
@@ -2,8 +2,10 @@
 #define TRANSFORMATION_
 
 #include "settings.hpp"
+#include "errors.hpp"
 
 namespace cube {
+	/* Automorphism of Q_n given by swapped coordinates followed by permutation of coordinates. */
 	struct transformation {
 		/* Default constructor - creates empty transformation. */
 		transformation() { clear(); }
@@ -27,6 +29,63 @@ namespace cube {
 			return true;
 		}
 		
+		/* Transforms vertex_id by this transformation, the transformation must be unique. */
+		sfi apply(sfi vertex_id) const {
+#ifdef _DEBUG
+			check_validity();
+#endif // _DEBUG
+
+			//swapping coordinates
+			vertex_id ^= dim_swap;
+
+			//permutating coordinates values
+			sfi transformed_vertex = 0;
+			FOR_DIMENSION(dim_id) {
+				if (vertex_id & (1 << dim_id))
+					transformed_vertex ^= (1 << top_one[dim_permutation[dim_id]]);
+			}
+			return transformed_vertex;
+		}
+
+		/* Returns vertex which will give vertex_id if transformed by this transformation, the transformation must be unique. */
+		sfi apply_inverse(sfi vertex_id) const {
+#ifdef _DEBUG
+			check_validity();
+#endif // _DEBUG
+
+			//permutating coordinates (we need to do inverse the actions in respect to apply())
+			sfi transformed_vertex = 0;
+			FOR_DIMENSION(dim_id) {
+				if (vertex_id & dim_permutation[dim_id])
+					transformed_vertex ^= (1 << dim_id);
+			}
+
+			//swapping coordinates values
+			transformed_vertex ^= dim_swap;
+
+			return transformed_vertex;
+		}
+
+		/* Checks that the transformation is unique and the shuffle of coordinates is a permutation. */
+		void check_validity() const {
+			//Test of transformation uniqueness
+			FOR_DIMENSION(dim_id) {
+				if (hamming[dim_permutation[dim_id]] != 1)
+					errors::assert_error("Transformation data are not complete!");
+			}
+
+			//Test of its validity (the shuffle of coordinates should be a permutation).
+			dimension_states used_dims;
+			FOR_DIMENSION(dim_id) {
+				used_dims[dim_id] = false;
+			}
+			FOR_DIMENSION(dim_id) {
+				if (used_dims[top_one[dim_permutation[dim_id]]])
+					errors::assert_error("Transformation data are corrupted!");
+				used_dims[top_one[dim_permutation[dim_id]]] = true;
+			}
+		}
+
 		//i-th bit is set to one iff i-th coordinate is swapped
 		sfi dim_swap; 
 